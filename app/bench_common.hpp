@@ -0,0 +1,135 @@
+#ifndef bench_common_hpp
+#define bench_common_hpp
+
+// Helpers shared by the Google Benchmark sources of bench_containers.
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ra::bench {
+
+// Counts the hardware cache misses of this thread in user space
+// between start() and stop(), if the kernel lets us.
+class cache_miss_counter {
+public:
+  cache_miss_counter()
+  {
+#if defined(__linux__)
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+  }
+
+  ~cache_miss_counter()
+  {
+#if defined(__linux__)
+    if(fd_ >= 0)
+    {
+      close(fd_);
+    }
+#endif
+  }
+
+  cache_miss_counter(const cache_miss_counter&) = delete;
+  cache_miss_counter& operator=(const cache_miss_counter&) = delete;
+
+  bool available() const { return fd_ >= 0; }
+
+  void start()
+  {
+#if defined(__linux__)
+    if(fd_ >= 0)
+    {
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  void stop()
+  {
+#if defined(__linux__)
+    if(fd_ >= 0)
+    {
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    }
+#endif
+  }
+
+  // Returns the number of misses counted so far.
+  std::uint64_t read() const
+  {
+    std::uint64_t n = 0;
+#if defined(__linux__)
+    if(fd_ >= 0 && ::read(fd_, &n, sizeof(n)) != sizeof(n))
+    {
+      n = 0;
+    }
+#endif
+    return n;
+  }
+
+private:
+  int fd_ = -1;
+};
+
+// Times the body of a benchmark: pauses and resumes the timer and
+// the cache-miss counter together, and reports the misses per item
+// when the state is destroyed.
+class timed_run {
+public:
+  timed_run(benchmark::State& state, std::size_t items_per_iteration) :
+    state_(state), items_(items_per_iteration)
+  {
+    misses_.start();
+  }
+
+  ~timed_run()
+  {
+    misses_.stop();
+    std::int64_t items = std::int64_t(state_.iterations() * items_);
+    state_.SetItemsProcessed(items);
+    if(misses_.available() && items != 0)
+    {
+      state_.counters["cache_misses"] =
+        double(misses_.read()) / double(items);
+    }
+  }
+
+  void pause()
+  {
+    misses_.stop();
+    state_.PauseTiming();
+  }
+
+  void resume()
+  {
+    state_.ResumeTiming();
+    misses_.start();
+  }
+
+private:
+  benchmark::State& state_;
+  std::size_t items_;
+  cache_miss_counter misses_;
+};
+
+// Registers the benchmarks of sv_set and its variants against one
+// another (see bench_sv_set.cpp), adding sets of 10^8 keys to some
+// of them if large is true.
+void register_sv_set_benchmarks(bool large);
+
+}
+
+#endif
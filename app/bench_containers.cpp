@@ -0,0 +1,440 @@
+// Benchmarks of sv_set and ra::intrusive::list against the standard
+// (and, if available, Boost) containers, built on Google Benchmark,
+// together with those of bench_sv_set.cpp, which compare sv_set with
+// its variants.
+// Run through the bench target, which writes the results as JSON to
+// bench.json in the build directory, or directly, e.g.
+//   bench_containers --benchmark_filter='find/.*uint32'
+//     --benchmark_out=find.json --benchmark_out_format=json
+// The benchmarks in this file are run for 1000, 10000 and 100000
+// elements, and report items_per_second with one item per element or
+// key. The option --large adds sets of 10^8 keys to some of those of
+// bench_sv_set.cpp.
+// On Linux, the cache misses of the timed code are read with
+// perf_event_open and reported as cache_misses per item, when the
+// kernel allows it (see /proc/sys/kernel/perf_event_paranoid).
+#include "ra/sv_set.hpp"
+#include "ra/intrusive_list.hpp"
+#include "bench_common.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#ifdef RA_BENCH_BOOST
+#include <boost/container/flat_set.hpp>
+#include <boost/intrusive/list.hpp>
+#endif
+
+using namespace ra::container;
+using ra::bench::cache_miss_counter;
+using ra::bench::timed_run;
+
+namespace {
+
+// A sorted std::vector, searched with std::lower_bound: the
+// baseline that sv_set is measured against.
+template <class Key>
+class sorted_vector {
+public:
+  using value_type = Key;
+  using const_iterator = typename std::vector<Key>::const_iterator;
+
+  bool insert(const Key& k)
+  {
+    auto pos = std::lower_bound(keys_.begin(), keys_.end(), k);
+    if(pos != keys_.end() && !(k < *pos))
+    {
+      return false;
+    }
+    keys_.insert(pos, k);
+    return true;
+  }
+
+  const_iterator find(const Key& k) const
+  {
+    auto pos = std::lower_bound(keys_.begin(), keys_.end(), k);
+    return (pos != keys_.end() && !(k < *pos)) ? pos : keys_.end();
+  }
+
+  void erase(const_iterator pos) { keys_.erase(pos); }
+
+  const_iterator begin() const { return keys_.begin(); }
+  const_iterator end() const { return keys_.end(); }
+
+private:
+  std::vector<Key> keys_;
+};
+
+template <class Key>
+Key make_key(unsigned x);
+
+template <>
+std::uint32_t make_key<std::uint32_t>(unsigned x)
+{
+  return x;
+}
+
+//long enough to be allocated, as most string keys are
+template <>
+std::string make_key<std::string>(unsigned x)
+{
+  std::string digits = std::to_string(x);
+  return "key-" + std::string(20 - digits.size(), '0') + digits;
+}
+
+// Returns n distinct keys in random order. They are made from even
+// numbers, so keys made from odd numbers are certain to miss.
+template <class Key>
+std::vector<Key> shuffled_keys(std::size_t n)
+{
+  std::vector<Key> keys;
+  keys.reserve(n);
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    keys.push_back(make_key<Key>(unsigned(2 * i)));
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(n));
+  return keys;
+}
+
+// Returns n keys to look up, half of them in shuffled_keys(n).
+template <class Key>
+std::vector<Key> query_keys(std::size_t n)
+{
+  std::mt19937 gen(unsigned(n) + 1);
+  std::vector<Key> queries;
+  queries.reserve(n);
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    queries.push_back(make_key<Key>(unsigned(gen() % (2 * n))));
+  }
+  return queries;
+}
+
+template <class Set>
+Set make_set(const std::vector<typename Set::value_type>& keys)
+{
+  Set s;
+  for(const auto& k : keys)
+  {
+    s.insert(k);
+  }
+  return s;
+}
+
+template <class Key>
+std::size_t weight(const Key& k)
+{
+  return std::size_t(k);
+}
+
+std::size_t weight(const std::string& k)
+{
+  return k.size();
+}
+
+template <class Set>
+void insert_keys(benchmark::State& state)
+{
+  auto keys = shuffled_keys<typename Set::value_type>(state.range(0));
+  timed_run run(state, keys.size());
+  for(auto _ : state)
+  {
+    Set s;
+    for(const auto& k : keys)
+    {
+      s.insert(k);
+    }
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+template <class Set>
+void find_keys(benchmark::State& state)
+{
+  using key_type = typename Set::value_type;
+  Set s = make_set<Set>(shuffled_keys<key_type>(state.range(0)));
+  auto queries = query_keys<key_type>(state.range(0));
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    std::size_t hits = 0;
+    for(const auto& k : queries)
+    {
+      hits += s.find(k) != s.end();
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+}
+
+template <class Set>
+void erase_keys(benchmark::State& state)
+{
+  auto keys = shuffled_keys<typename Set::value_type>(state.range(0));
+  Set full = make_set<Set>(keys);
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+  timed_run run(state, keys.size());
+  for(auto _ : state)
+  {
+    run.pause();
+    Set s(full);
+    run.resume();
+    for(const auto& k : keys)
+    {
+      s.erase(s.find(k));
+    }
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+template <class Set>
+void iterate_keys(benchmark::State& state)
+{
+  Set s = make_set<Set>(shuffled_keys<typename Set::value_type>(
+    state.range(0)));
+  timed_run run(state, state.range(0));
+  for(auto _ : state)
+  {
+    std::size_t sum = 0;
+    for(const auto& k : s)
+    {
+      sum += weight(k);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+template <class Set>
+void copy_set(benchmark::State& state)
+{
+  Set s = make_set<Set>(shuffled_keys<typename Set::value_type>(
+    state.range(0)));
+  timed_run run(state, state.range(0));
+  for(auto _ : state)
+  {
+    Set copy(s);
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+struct node {
+  explicit node(unsigned v) : value(v) {}
+  unsigned value;
+  ra::intrusive::list_hook hook;
+#ifdef RA_BENCH_BOOST
+  boost::intrusive::list_member_hook<> boost_hook;
+#endif
+};
+
+using ra_list = ra::intrusive::list<node, &node::hook>;
+
+#ifdef RA_BENCH_BOOST
+using boost_list = boost::intrusive::list<node,
+  boost::intrusive::member_hook<node, boost::intrusive::list_member_hook<>,
+    &node::boost_hook>, boost::intrusive::constant_time_size<true>>;
+#endif
+
+// The nodes of the intrusive lists, allocated up front (as they
+// would be by their owners), in a random order so that a walk of
+// the list jumps around memory as it would in a long-running
+// program.
+std::vector<node*> list_nodes(std::vector<node>& storage, std::size_t n)
+{
+  storage.clear();
+  storage.reserve(n);
+  std::vector<node*> nodes;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    storage.emplace_back(unsigned(i));
+    nodes.push_back(&storage.back());
+  }
+  std::shuffle(nodes.begin(), nodes.end(), std::mt19937(n));
+  return nodes;
+}
+
+template <class List>
+void fill(List& l, const std::vector<node*>& nodes)
+{
+  for(node* p : nodes)
+  {
+    l.push_back(*p);
+  }
+}
+
+void fill(std::list<unsigned>& l, const std::vector<node*>& nodes)
+{
+  for(node* p : nodes)
+  {
+    l.push_back(p->value);
+  }
+}
+
+unsigned value_of(const node& n) { return n.value; }
+unsigned value_of(unsigned v) { return v; }
+
+template <class List>
+void list_push_back(benchmark::State& state)
+{
+  std::vector<node> storage;
+  auto nodes = list_nodes(storage, state.range(0));
+  timed_run run(state, nodes.size());
+  for(auto _ : state)
+  {
+    List l;
+    fill(l, nodes);
+    benchmark::DoNotOptimize(l);
+    l.clear();
+  }
+}
+
+template <class List>
+void list_iterate(benchmark::State& state)
+{
+  std::vector<node> storage;
+  auto nodes = list_nodes(storage, state.range(0));
+  List l;
+  fill(l, nodes);
+  timed_run run(state, nodes.size());
+  for(auto _ : state)
+  {
+    unsigned sum = 0;
+    for(auto it = l.begin(); it != l.end(); ++it)
+    {
+      sum += value_of(*it);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  l.clear();
+}
+
+template <class List>
+void list_erase(benchmark::State& state)
+{
+  std::vector<node> storage;
+  auto nodes = list_nodes(storage, state.range(0));
+  timed_run run(state, nodes.size());
+  for(auto _ : state)
+  {
+    run.pause();
+    List l;
+    fill(l, nodes);
+    run.resume();
+    while(l.size() != 0)
+    {
+      l.erase(l.begin());
+    }
+    benchmark::DoNotOptimize(l);
+  }
+}
+
+// Moves every element of one list to another and back, relinking
+// the whole chain with splice, or (with Splice false) one erase and
+// push_back per node as before splice existed.
+template <class List, bool Splice>
+void list_migrate(benchmark::State& state)
+{
+  std::vector<node> storage;
+  auto nodes = list_nodes(storage, state.range(0));
+  List from;
+  List to;
+  fill(from, nodes);
+  timed_run run(state, 2 * nodes.size());
+  for(auto _ : state)
+  {
+    if constexpr(Splice)
+    {
+      to.splice(to.end(), from);
+      from.splice(from.end(), to);
+    }
+    else
+    {
+      for(List* l : {&from, &to})
+      {
+        List& other = l == &from ? to : from;
+        while(l->size() != 0)
+        {
+          auto& n = *l->begin();
+          l->erase(l->begin());
+          other.push_back(n);
+        }
+      }
+    }
+    benchmark::DoNotOptimize(from);
+  }
+  from.clear();
+}
+
+template <class F>
+void add(const std::string& name, F f)
+{
+  benchmark::RegisterBenchmark(name.c_str(), f)->RangeMultiplier(10)
+    ->Range(1000, 100000);
+}
+
+template <class Set>
+void add_set(const std::string& container)
+{
+  add("insert/" + container, insert_keys<Set>);
+  add("find/" + container, find_keys<Set>);
+  add("erase/" + container, erase_keys<Set>);
+  add("iterate/" + container, iterate_keys<Set>);
+  add("copy/" + container, copy_set<Set>);
+}
+
+template <class Key>
+void add_sets(const std::string& key)
+{
+  add_set<sv_set<Key>>("sv_set<" + key + ">");
+  add_set<std::set<Key>>("std::set<" + key + ">");
+  add_set<std::unordered_set<Key>>("std::unordered_set<" + key + ">");
+  add_set<sorted_vector<Key>>("sorted_vector<" + key + ">");
+#ifdef RA_BENCH_BOOST
+  add_set<boost::container::flat_set<Key>>("boost::flat_set<" + key + ">");
+#endif
+}
+
+template <class List>
+void add_list(const std::string& container)
+{
+  add("push_back/" + container, list_push_back<List>);
+  add("iterate/" + container, list_iterate<List>);
+  add("erase/" + container, list_erase<List>);
+  add("splice/" + container, list_migrate<List, true>);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  //--large is ours, so it is taken out before Google Benchmark sees
+  //the arguments
+  char** last = std::remove_if(argv + 1, argv + argc, [](const char* arg) {
+    return std::string(arg) == "--large";
+  });
+  bool large = last != argv + argc;
+  argc = int(last - argv);
+  benchmark::Initialize(&argc, argv);
+  if(benchmark::ReportUnrecognizedArguments(argc, argv))
+  {
+    return 1;
+  }
+  add_sets<std::uint32_t>("uint32");
+  add_sets<std::string>("string");
+  add_list<ra_list>("ra::intrusive::list");
+  add("erase_push_back/ra::intrusive::list", list_migrate<ra_list, false>);
+  add_list<std::list<unsigned>>("std::list");
+#ifdef RA_BENCH_BOOST
+  add_list<boost_list>("boost::intrusive::list");
+#endif
+  ra::bench::register_sv_set_benchmarks(large);
+  benchmark::AddCustomContext("cache_misses", cache_miss_counter().available()
+    ? "perf_event_open" : "unavailable");
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
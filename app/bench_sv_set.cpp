@@ -0,0 +1,974 @@
+// Benchmarks of sv_set against its variants (the frozen, log,
+// segmented, concurrent, sharded, compressed, string and static
+// sets, and sv_map) and against its own options (range operations,
+// search policies, filters, relocation and statistics), registered
+// with Google Benchmark by register_sv_set_benchmarks() and run by
+// bench_containers.
+// Each benchmark is named operation/variant, so that a filter such
+// as --benchmark_filter='^frozen_find/' picks out the variants of one
+// comparison, and reports items_per_second with one item per key
+// inserted, looked up or erased. Some also report the memory used,
+// as bytes_per_key or a similar counter.
+#include "ra/sv_set.hpp"
+#include "ra/sv_set_frozen.hpp"
+#include "ra/sv_log_set.hpp"
+#include "ra/concurrent_sv_set.hpp"
+#include "ra/sharded_sv_set.hpp"
+#include "ra/compressed_sv_set.hpp"
+#include "ra/sv_map.hpp"
+#include "ra/static_sv_set.hpp"
+#include "ra/sv_string_set.hpp"
+#include "ra/segmented_sv_set.hpp"
+#include "bench_common.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace ra::container;
+using ra::bench::timed_run;
+
+namespace {
+
+// The number of lookups timed by each iteration of the lookup
+// benchmarks.
+constexpr std::size_t lookups = 1000000;
+
+// Returns n random keys (not necessarily unique).
+std::vector<unsigned> random_keys(std::size_t n, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::vector<unsigned> keys(n);
+  for(auto& k : keys)
+  {
+    k = gen();
+  }
+  return keys;
+}
+
+// Returns random queries, every other one of which is one of keys.
+std::vector<unsigned> half_hits(const std::vector<unsigned>& keys,
+  unsigned seed)
+{
+  auto queries = random_keys(lookups, seed);
+  for(std::size_t i = 0; i < queries.size(); i += 2)
+  {
+    queries[i] = keys[queries[i] % keys.size()];
+  }
+  return queries;
+}
+
+// k single inserts (or, if Range is true, one range insert of the
+// same k keys) into a set that already holds 100000 keys.
+template <bool Range>
+void insert_batch(benchmark::State& state)
+{
+  auto keys = random_keys(100000, 1);
+  const sv_set<unsigned> base(keys.begin(), keys.end());
+  auto batch = random_keys(state.range(0), 2);
+  timed_run run(state, batch.size());
+  for(auto _ : state)
+  {
+    run.pause();
+    sv_set<unsigned> s(base);
+    run.resume();
+    if constexpr(Range)
+    {
+      s.insert(batch.begin(), batch.end());
+    }
+    else
+    {
+      for(auto k : batch)
+      {
+        s.insert(k);
+      }
+    }
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+// Builds a set from n unsorted keys on one thread, or on all of them
+// if Parallel is true.
+template <bool Parallel>
+void construct_unsorted(benchmark::State& state)
+{
+  auto keys = random_keys(state.range(0), 3);
+  timed_run run(state, keys.size());
+  for(auto _ : state)
+  {
+    if constexpr(Parallel)
+    {
+      sv_set<unsigned> s(ra::util::par, keys.begin(), keys.end());
+      benchmark::DoNotOptimize(s);
+    }
+    else
+    {
+      sv_set<unsigned> s(keys.begin(), keys.end());
+      benchmark::DoNotOptimize(s);
+    }
+  }
+}
+
+// Lookups (half of which hit) in a set of n keys, copied into Set:
+// an sv_set or one of the frozen layouts.
+template <class Set>
+void frozen_find(benchmark::State& state)
+{
+  auto keys = random_keys(state.range(0), 4);
+  const Set s(sv_set<unsigned>(keys.begin(), keys.end()));
+  auto queries = half_hits(keys, 5);
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    std::size_t hits = 0;
+    for(auto q : queries)
+    {
+      hits += s.find(q) != s.end();
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+}
+
+// A loop of find calls (or, if Batch is true, one find_many) on a set
+// of n keys, for random (or, if Sorted is true, sorted) queries.
+template <bool Batch, bool Sorted>
+void find_many(benchmark::State& state)
+{
+  auto keys = random_keys(state.range(0), 6);
+  const sv_set<std::uint64_t> s(keys.begin(), keys.end());
+  auto q32 = half_hits(keys, 7);
+  std::vector<std::uint64_t> queries(q32.begin(), q32.end());
+  if constexpr(Sorted)
+  {
+    std::sort(queries.begin(), queries.end());
+  }
+  std::vector<sv_set<std::uint64_t>::const_iterator> out(queries.size());
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    if constexpr(Batch)
+    {
+      s.find_many(queries.begin(), queries.end(), out.begin());
+    }
+    else
+    {
+      for(std::size_t i = 0; i < queries.size(); ++i)
+      {
+        out[i] = s.find(queries[i]);
+      }
+    }
+    benchmark::DoNotOptimize(out.data());
+    benchmark::ClobberMemory();
+  }
+}
+
+using stats_set = sv_set<unsigned, std::less<unsigned>,
+  std::allocator<unsigned>, binary_search_policy, geometric_growth<>,
+  ra::util::container_stats>;
+
+// n random keys inserted one at a time into Set: an sv_set (with or
+// without statistics), an sv_log_set (compacted at the end), a
+// segmented_sv_set or, unsorted, a std::vector.
+template <class Set>
+void single_insert(benchmark::State& state)
+{
+  auto keys = random_keys(state.range(0), 10);
+  timed_run run(state, keys.size());
+  for(auto _ : state)
+  {
+    Set s;
+    for(auto k : keys)
+    {
+      if constexpr(std::is_same_v<Set, std::vector<unsigned>>)
+      {
+        s.push_back(k);
+      }
+      else
+      {
+        s.insert(k);
+      }
+    }
+    if constexpr(std::is_same_v<Set, sv_log_set<unsigned>>)
+    {
+      s.compact();
+    }
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+// Lookups (nearly all of which miss) in a Set of n random keys
+// inserted one at a time.
+template <class Set>
+void contains(benchmark::State& state)
+{
+  Set s;
+  for(auto k : random_keys(state.range(0), 26))
+  {
+    s.insert(k);
+  }
+  auto queries = random_keys(lookups, 27);
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    std::size_t hits = 0;
+    for(auto q : queries)
+    {
+      hits += s.contains(q);
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+}
+
+// A shared_ptr<unsigned> ordered by the value it points to. The
+// shared_ptr itself is trivially relocatable; the wrapper is not,
+// unless Relocate is true.
+template <bool Relocate>
+struct shared_key {
+  std::shared_ptr<unsigned> p;
+  bool operator<(const shared_key& other) const { return *p < *other.p; }
+};
+
+}
+
+template <>
+struct ra::container::is_trivially_relocatable<shared_key<true>> :
+  std::true_type {};
+
+namespace {
+
+// n single inserts and then n / 2 erasures of keys of type
+// shared_key<Relocate>, which are moved one by one, or relocated with
+// memmove if Relocate is true.
+template <bool Relocate>
+void shift_shared_ptr(benchmark::State& state)
+{
+  auto keys = random_keys(state.range(0), 17);
+  std::vector<shared_key<Relocate>> owners;
+  for(auto k : keys)
+  {
+    owners.push_back({std::make_shared<unsigned>(k)});
+  }
+  timed_run run(state, keys.size() + keys.size() / 2);
+  for(auto _ : state)
+  {
+    sv_set<shared_key<Relocate>> s;
+    for(const auto& k : owners)
+    {
+      s.insert(k);
+    }
+    for(std::size_t i = 0; i < keys.size() / 2 && s.size() != 0; ++i)
+    {
+      s.erase(s.begin() + keys[i] % s.size());
+    }
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+enum class erase_method { one_by_one, erase_keys, erase_if };
+
+// Erases k keys from a set of n: one find and erase at a time, with
+// one erase_keys() of the sorted keys, or with one erase_if().
+template <erase_method Method>
+void erase_batch(benchmark::State& state)
+{
+  auto keys = random_keys(state.range(0), 18);
+  const sv_set<unsigned> base(keys.begin(), keys.end());
+  std::vector<unsigned> expired;
+  for(std::int64_t i = 0; i < state.range(1); ++i)
+  {
+    expired.push_back(base.begin()[keys[i] % base.size()]);
+  }
+  std::sort(expired.begin(), expired.end());
+  timed_run run(state, expired.size());
+  for(auto _ : state)
+  {
+    run.pause();
+    sv_set<unsigned> s(base);
+    run.resume();
+    if constexpr(Method == erase_method::one_by_one)
+    {
+      for(auto x : expired)
+      {
+        auto pos = s.find(x);
+        if(pos != s.end())
+        {
+          s.erase(pos);
+        }
+      }
+    }
+    else if constexpr(Method == erase_method::erase_keys)
+    {
+      s.erase_keys(expired.begin(), expired.end());
+    }
+    else
+    {
+      erase_if(s, [&](unsigned x) {
+        return std::binary_search(expired.begin(), expired.end(), x);
+      });
+    }
+    benchmark::DoNotOptimize(s);
+  }
+}
+
+// The intersection of sets of n and n / ratio keys, about half of the
+// smaller one common, with set_intersection or (if Std is true) with
+// std::set_intersection into a std::vector through
+// std::back_inserter.
+template <bool Std>
+void intersection(benchmark::State& state)
+{
+  auto k1 = random_keys(state.range(0), 8);
+  auto k2 = random_keys(state.range(0) / state.range(1), 9);
+  for(std::size_t i = 0; i < k2.size(); i += 2)
+  {
+    k2[i] = k1[i];
+  }
+  const sv_set<unsigned> a(k1.begin(), k1.end());
+  const sv_set<unsigned> b(k2.begin(), k2.end());
+  timed_run run(state, a.size() + b.size());
+  for(auto _ : state)
+  {
+    if constexpr(Std)
+    {
+      std::vector<unsigned> out;
+      std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+        std::back_inserter(out));
+      benchmark::DoNotOptimize(out);
+    }
+    else
+    {
+      auto out = set_intersection(a, b);
+      benchmark::DoNotOptimize(out);
+    }
+  }
+}
+
+// Lookups (half of which hit) in an sv_set or (if Compressed is true)
+// a compressed_sv_set of n IDs with random gaps of 1 to 32.
+template <bool Compressed>
+void compressed_find(benchmark::State& state)
+{
+  std::size_t n = state.range(0);
+  auto gaps = random_keys(n, 14);
+  std::vector<std::uint64_t> keys(n);
+  std::uint64_t id = 1u << 20;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    id += 1 + gaps[i] % 32;
+    keys[i] = id;
+  }
+  auto q32 = random_keys(lookups, 15);
+  std::vector<std::uint64_t> queries(q32.size());
+  for(std::size_t i = 0; i < queries.size(); ++i)
+  {
+    queries[i] = i % 2 ? keys[q32[i] % n] : keys[0] + q32[i] % (id - keys[0]);
+  }
+  const sv_set<std::uint64_t> s(keys.begin(), keys.end());
+  std::conditional_t<Compressed, const compressed_sv_set<std::uint64_t>,
+    const sv_set<std::uint64_t>&> c(s);
+  {
+    timed_run run(state, queries.size());
+    for(auto _ : state)
+    {
+      std::size_t hits = 0;
+      for(auto q : queries)
+      {
+        hits += c.contains(q);
+      }
+      benchmark::DoNotOptimize(hits);
+    }
+  }
+  if constexpr(Compressed)
+  {
+    state.counters["bytes_per_key"] = double(c.memory_bytes()) / n;
+  }
+  else
+  {
+    state.counters["bytes_per_key"] = double(sizeof(std::uint64_t));
+  }
+}
+
+// Lookups (half of which hit) of n keys with 120-byte values in an
+// sv_map or (if Map is false) in a sorted std::vector of pairs.
+template <bool Map>
+void map_find(benchmark::State& state)
+{
+  struct payload {
+    unsigned char bytes[120];
+  };
+  auto keys = random_keys(state.range(0), 19);
+  std::vector<std::pair<unsigned, payload>> pairs;
+  for(auto k : keys)
+  {
+    payload p;
+    std::memset(p.bytes, k & 0xff, sizeof(p.bytes));
+    pairs.emplace_back(k, p);
+  }
+  const sv_map<unsigned, payload> m(pairs.begin(), pairs.end());
+  std::sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) {
+    return a.first < b.first;
+  });
+  pairs.erase(std::unique(pairs.begin(), pairs.end(),
+    [](const auto& a, const auto& b) { return a.first == b.first; }),
+    pairs.end());
+  auto queries = half_hits(keys, 20);
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    std::size_t sum = 0;
+    for(auto q : queries)
+    {
+      if constexpr(Map)
+      {
+        auto pos = m.find(q);
+        if(pos != m.end())
+        {
+          sum += pos.value().bytes[0];
+        }
+      }
+      else
+      {
+        auto pos = std::lower_bound(pairs.begin(), pairs.end(), q,
+          [](const auto& p, unsigned k) { return p.first < k; });
+        if(pos != pairs.end() && pos->first == q)
+        {
+          sum += pos->second.bytes[0];
+        }
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+}
+
+// Lookups that mostly miss (19 in 20) in an sv_set of n keys, with a
+// Bloom filter in front of the search if Filtered is true.
+template <bool Filtered>
+void filtered_find(benchmark::State& state)
+{
+  using set = std::conditional_t<Filtered, sv_set<unsigned,
+    std::less<unsigned>, std::allocator<unsigned>, filtered_search_policy<>>,
+    sv_set<unsigned>>;
+  auto keys = random_keys(state.range(0), 21);
+  const set s(keys.begin(), keys.end());
+  auto queries = random_keys(lookups, 22);
+  for(std::size_t i = 0; i < queries.size(); i += 20)
+  {
+    queries[i] = keys[queries[i] % keys.size()];
+  }
+  //the first lookup builds the filter, so it is not timed
+  benchmark::DoNotOptimize(s.contains(queries[0]));
+  if constexpr(Filtered)
+  {
+    const_cast<filtered_search_policy<>&>(s.get_search_policy())
+      .reset_counters();
+  }
+  {
+    timed_run run(state, queries.size());
+    for(auto _ : state)
+    {
+      std::size_t hits = 0;
+      for(auto q : queries)
+      {
+        hits += s.contains(q);
+      }
+      benchmark::DoNotOptimize(hits);
+    }
+  }
+  if constexpr(Filtered)
+  {
+    const auto& policy = s.get_search_policy();
+    state.counters["rejected_percent"] =
+      100.0 * policy.rejections() / policy.lookups();
+    state.counters["bits_per_key"] = 8.0 * policy.filter_bytes() / s.size();
+  }
+}
+
+// Lookups in a 64-key opcode table held in a constexpr static_sv_set
+// or (if Static is false) in an sv_set built at run time.
+template <bool Static>
+void static_find(benchmark::State& state)
+{
+  static constexpr static_sv_set<unsigned, 64> table(
+    []() constexpr {
+      std::array<unsigned, 64> keys{};
+      for(unsigned i = 0; i < 64; ++i)
+      {
+        keys[i] = (i * 37 + 11) % 251;
+      }
+      return keys;
+    }());
+  const sv_set<unsigned> dynamic(table.begin(), table.end());
+  auto queries = random_keys(lookups, 23);
+  for(auto& q : queries)
+  {
+    q %= 256;
+  }
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    std::size_t hits = 0;
+    for(auto q : queries)
+    {
+      hits += Static ? table.contains(q) : dynamic.contains(q);
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+}
+
+// Lookups (half of which miss) among n hostnames held in a Set: an
+// sv_set<std::string> or an sv_string_set.
+template <class Set>
+void string_find(benchmark::State& state)
+{
+  static const char* const domains[] = {".com", ".org", ".net", ".io"};
+  std::size_t n = state.range(0);
+  auto ids = random_keys(n, 24);
+  std::vector<std::string> hosts;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    hosts.push_back("host-" + std::to_string(ids[i]) + ".cluster-" +
+      std::to_string(ids[i] % 97) + ".example" + domains[ids[i] % 4]);
+  }
+  const Set s(hosts.begin(), hosts.end());
+  std::vector<std::string> queries;
+  auto q = random_keys(lookups, 25);
+  for(std::size_t i = 0; i < q.size(); ++i)
+  {
+    queries.push_back(i % 2 ? hosts[q[i] % n] : hosts[q[i] % n] + "x");
+  }
+  {
+    timed_run run(state, queries.size());
+    for(auto _ : state)
+    {
+      std::size_t hits = 0;
+      for(const auto& k : queries)
+      {
+        hits += s.contains(k);
+      }
+      benchmark::DoNotOptimize(hits);
+    }
+  }
+  if constexpr(std::is_same_v<Set, sv_string_set>)
+  {
+    state.counters["bytes_per_string"] = double(s.memory_bytes()) / s.size();
+  }
+  else
+  {
+    //std::string keys above 15 bytes have a heap block of their own
+    std::size_t bytes = s.capacity() * sizeof(std::string);
+    for(const auto& h : s)
+    {
+      bytes += h.size() > 15 ? h.size() + 1 : 0;
+    }
+    state.counters["bytes_per_string"] = double(bytes) / s.size();
+  }
+}
+
+enum class distribution { uniform, zipf, clustered };
+
+// Lookups (half of which hit) in an sv_set of about n keys searched
+// with Search, the keys drawn from the distribution Keys.
+template <class Search, distribution Keys>
+void search_policy(benchmark::State& state)
+{
+  std::size_t n = state.range(0);
+  std::mt19937_64 gen(16);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  std::vector<std::uint64_t> keys(n);
+  for(auto& k : keys)
+  {
+    if constexpr(Keys == distribution::uniform)
+    {
+      k = gen() >> 8;
+    }
+    else if constexpr(Keys == distribution::zipf)
+    {
+      //most keys are small, with a long tail of large ones
+      k = std::uint64_t(1e6 / std::pow(1.0 - unit(gen), 1.2));
+    }
+    else
+    {
+      //dense runs of keys around a few random centers
+      k = (gen() % 64) * (std::uint64_t(1) << 40) + gen() % (n * 4);
+    }
+  }
+  const sv_set<std::uint64_t, std::less<std::uint64_t>,
+    std::allocator<std::uint64_t>, Search> s(keys.begin(), keys.end());
+  std::vector<std::uint64_t> queries(lookups);
+  for(std::size_t i = 0; i < queries.size(); ++i)
+  {
+    std::uint64_t k = s.begin()[gen() % s.size()];
+    queries[i] = i % 2 ? k : k + 1;
+  }
+  //the first lookup builds any model, so it is not timed
+  benchmark::DoNotOptimize(s.contains(queries[0]));
+  timed_run run(state, queries.size());
+  for(auto _ : state)
+  {
+    std::size_t hits = 0;
+    for(auto q : queries)
+    {
+      hits += s.contains(q);
+    }
+    benchmark::DoNotOptimize(hits);
+  }
+}
+
+// The number of lookups made by each reader in each iteration of
+// concurrent_find.
+constexpr std::size_t reader_lookups = 1 << 16;
+
+// Lookups in a set of 10^6 keys on a number of reader threads, while
+// one writer publishes a batch of 64 changes every millisecond, in a
+// concurrent_sv_set or (if Rcu is false) in an sv_set behind a
+// std::shared_mutex. The throughput counts the readers together.
+template <bool Rcu>
+void concurrent_find(benchmark::State& state)
+{
+  auto keys = random_keys(1000000, 11);
+  auto queries = random_keys(reader_lookups, 12);
+  concurrent_sv_set<unsigned> rcu(sv_set<unsigned>(keys.begin(), keys.end()));
+  sv_set<unsigned> locked(keys.begin(), keys.end());
+  std::shared_mutex mutex;
+  auto lookup = [&](unsigned q) {
+    if constexpr(Rcu)
+    {
+      return rcu.contains(q);
+    }
+    else
+    {
+      std::shared_lock<std::shared_mutex> lock(mutex);
+      return locked.contains(q);
+    }
+  };
+
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for(unsigned round = 0; !done.load(); ++round)
+    {
+      if constexpr(Rcu)
+      {
+        for(unsigned i = 0; i < 64; ++i)
+        {
+          if(round % 2 == 0)
+          {
+            rcu.insert(i);
+          }
+          else
+          {
+            rcu.erase(i);
+          }
+        }
+        rcu.publish();
+      }
+      else
+      {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        for(unsigned i = 0; i < 64; ++i)
+        {
+          if(round % 2 == 0)
+          {
+            locked.insert(i);
+          }
+          else if(locked.find(i) != locked.end())
+          {
+            locked.erase(locked.find(i));
+          }
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+
+  unsigned threads = unsigned(state.range(0));
+  for(auto _ : state)
+  {
+    std::vector<std::thread> readers;
+    for(unsigned t = 0; t < threads; ++t)
+    {
+      readers.emplace_back([&, t] {
+        std::size_t hits = 0;
+        for(std::size_t i = 0; i < queries.size(); ++i)
+        {
+          hits += lookup(queries[(i + t * 4099) % queries.size()]);
+        }
+        benchmark::DoNotOptimize(hits);
+      });
+    }
+    for(auto& reader : readers)
+    {
+      reader.join();
+    }
+  }
+  done = true;
+  writer.join();
+  state.SetItemsProcessed(state.iterations() * threads * queries.size());
+}
+
+// 100000 random keys inserted by a number of writer threads, each
+// inserting its share, into a sharded_sv_set or (if Sharded is false)
+// into an sv_set behind a std::mutex.
+template <bool Sharded>
+void sharded_insert(benchmark::State& state)
+{
+  auto keys = random_keys(100000, 13);
+  unsigned threads = unsigned(state.range(0));
+  for(auto _ : state)
+  {
+    sharded_sv_set<unsigned, std::less<unsigned>, 32> sharded;
+    sv_set<unsigned> locked;
+    std::mutex mutex;
+    std::vector<std::thread> writers;
+    for(unsigned t = 0; t < threads; ++t)
+    {
+      writers.emplace_back([&, t] {
+        for(std::size_t i = t; i < keys.size(); i += threads)
+        {
+          if constexpr(Sharded)
+          {
+            sharded.insert(keys[i]);
+          }
+          else
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            locked.insert(keys[i]);
+          }
+        }
+      });
+    }
+    for(auto& writer : writers)
+    {
+      writer.join();
+    }
+    benchmark::DoNotOptimize(sharded);
+    benchmark::DoNotOptimize(locked);
+  }
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+// Inserts and erasures of random keys by each of the benchmark's
+// threads, on a set of 1000000 keys shared by all of them: a
+// sharded_sv_set or (if Sharded is false) an sv_set behind a
+// std::mutex. Each key is erased again right after it is inserted,
+// so the set neither grows nor rebalances, and the rate per thread
+// stays flat for as long as the operations scale.
+template <bool Sharded>
+void sharded_scaling(benchmark::State& state)
+{
+  static std::unique_ptr<sharded_sv_set<unsigned, std::less<unsigned>, 64>>
+    sharded;
+  static std::unique_ptr<sv_set<unsigned>> locked;
+  static std::mutex mutex;
+  if(state.thread_index() == 0)
+  {
+    auto keys = random_keys(1000000, 14);
+    sharded.reset(new sharded_sv_set<unsigned, std::less<unsigned>, 64>);
+    sharded->insert(keys.begin(), keys.end());
+    sharded->rebalance();
+    locked.reset(new sv_set<unsigned>(keys.begin(), keys.end()));
+  }
+  auto keys = random_keys(4096, 15 + unsigned(state.thread_index()));
+  std::size_t i = 0;
+  for(auto _ : state)
+  {
+    unsigned k = keys[i++ % keys.size()];
+    if constexpr(Sharded)
+    {
+      if(sharded->insert(k))
+      {
+        benchmark::DoNotOptimize(sharded->erase(k));
+      }
+    }
+    else
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto r = locked->insert(k);
+      if(r.second)
+      {
+        locked->erase(r.first);
+      }
+      benchmark::DoNotOptimize(r);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * 2);
+  if(state.thread_index() == 0)
+  {
+    sharded.reset();
+    locked.reset();
+  }
+}
+
+template <class F>
+benchmark::internal::Benchmark* add(const std::string& name, F f)
+{
+  return benchmark::RegisterBenchmark(name.c_str(), f);
+}
+
+// Adds the thread counts 1, 2, 4, ... up to the hardware concurrency
+// as arguments to b, which times the threads it starts in real time.
+void add_thread_counts(benchmark::internal::Benchmark* b)
+{
+  unsigned max_threads = std::max(2u, std::thread::hardware_concurrency());
+  for(unsigned threads = 1; threads <= max_threads; threads *= 2)
+  {
+    b->Arg(threads);
+  }
+  b->UseRealTime();
+}
+
+}
+
+void ra::bench::register_sv_set_benchmarks(bool large)
+{
+  for(auto* b : {add("insert_batch/single", insert_batch<false>),
+    add("insert_batch/range", insert_batch<true>)})
+  {
+    b->RangeMultiplier(16)->Range(1, 65536);
+  }
+
+  for(auto* b : {add("construct_unsorted/sequential",
+    construct_unsorted<false>), add("construct_unsorted/parallel",
+    construct_unsorted<true>)})
+  {
+    b->Arg(10000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+  }
+
+  for(auto* b : {add("frozen_find/sv_set", frozen_find<sv_set<unsigned>>),
+    add("frozen_find/eytzinger", frozen_find<sv_set_frozen<unsigned>>),
+    add("frozen_find/btree", frozen_find<sv_set_frozen<unsigned,
+      std::less<unsigned>, btree_layout>>),
+    add("find_many/find_random", find_many<false, false>),
+    add("find_many/find_many_random", find_many<true, false>),
+    add("find_many/find_sorted", find_many<false, true>),
+    add("find_many/find_many_sorted", find_many<true, true>)})
+  {
+    b->Arg(1000)->Arg(1000000);
+    if(large)
+    {
+      b->Arg(100000000);
+    }
+  }
+
+  for(auto* b : {add("single_insert/sv_set", single_insert<sv_set<unsigned>>),
+    add("single_insert/sv_log_set", single_insert<sv_log_set<unsigned>>),
+    add("single_insert/segmented_sv_set",
+      single_insert<segmented_sv_set<unsigned>>),
+    add("single_insert/sv_set+container_stats", single_insert<stats_set>),
+    add("single_insert/vector", single_insert<std::vector<unsigned>>)})
+  {
+    b->Arg(10000)->Arg(100000)->Arg(300000)->Unit(benchmark::kMillisecond);
+  }
+
+  for(auto* b : {add("contains/sv_set", contains<sv_set<unsigned>>),
+    add("contains/segmented_sv_set", contains<segmented_sv_set<unsigned>>),
+    add("contains/sv_set+container_stats", contains<stats_set>)})
+  {
+    b->Arg(100000)->Arg(300000);
+  }
+
+  for(auto* b : {add("shift_shared_ptr/moved", shift_shared_ptr<false>),
+    add("shift_shared_ptr/relocated", shift_shared_ptr<true>)})
+  {
+    b->Arg(10000)->Arg(30000)->Unit(benchmark::kMillisecond);
+  }
+
+  for(auto* b : {add("erase_batch/one_by_one",
+    erase_batch<erase_method::one_by_one>),
+    add("erase_batch/erase_keys", erase_batch<erase_method::erase_keys>),
+    add("erase_batch/erase_if", erase_batch<erase_method::erase_if>)})
+  {
+    b->Args({1000000, 1000})->Args({1000000, 10000});
+  }
+
+  for(auto* b : {add("set_intersection/std", intersection<true>),
+    add("set_intersection/sv_set", intersection<false>)})
+  {
+    for(int ratio : {1, 4, 64, 1024})
+    {
+      b->Args({1000000, ratio});
+    }
+  }
+
+  for(auto* b : {add("compressed_find/sv_set", compressed_find<false>),
+    add("compressed_find/compressed_sv_set", compressed_find<true>)})
+  {
+    b->Arg(1000000);
+    if(large)
+    {
+      b->Arg(100000000);
+    }
+  }
+
+  for(auto* b : {add("map_find/pair_vector", map_find<false>),
+    add("map_find/sv_map", map_find<true>)})
+  {
+    b->Arg(1000)->Arg(1000000);
+  }
+
+  for(auto* b : {add("filtered_find/sv_set", filtered_find<false>),
+    add("filtered_find/filtered", filtered_find<true>)})
+  {
+    b->Arg(10000)->Arg(1000000);
+  }
+
+  add("static_find/sv_set", static_find<false>);
+  add("static_find/static_sv_set", static_find<true>);
+
+  for(auto* b : {add("string_find/sv_set", string_find<sv_set<std::string>>),
+    add("string_find/sv_string_set", string_find<sv_string_set>)})
+  {
+    b->Arg(10000)->Arg(1000000);
+  }
+
+  for(auto* b : {
+    add("search_policy/binary/uniform",
+      search_policy<binary_search_policy, distribution::uniform>),
+    add("search_policy/interpolation/uniform",
+      search_policy<interpolation_search_policy, distribution::uniform>),
+    add("search_policy/learned/uniform",
+      search_policy<learned_search_policy<>, distribution::uniform>),
+    add("search_policy/binary/zipf",
+      search_policy<binary_search_policy, distribution::zipf>),
+    add("search_policy/interpolation/zipf",
+      search_policy<interpolation_search_policy, distribution::zipf>),
+    add("search_policy/learned/zipf",
+      search_policy<learned_search_policy<>, distribution::zipf>),
+    add("search_policy/binary/clustered",
+      search_policy<binary_search_policy, distribution::clustered>),
+    add("search_policy/interpolation/clustered",
+      search_policy<interpolation_search_policy, distribution::clustered>),
+    add("search_policy/learned/clustered",
+      search_policy<learned_search_policy<>, distribution::clustered>)})
+  {
+    b->Arg(1000000);
+  }
+
+  add_thread_counts(add("concurrent_find/shared_mutex",
+    concurrent_find<false>));
+  add_thread_counts(add("concurrent_find/concurrent_sv_set",
+    concurrent_find<true>));
+  add_thread_counts(add("sharded_insert/mutex", sharded_insert<false>)
+    ->Unit(benchmark::kMillisecond));
+  add_thread_counts(add("sharded_insert/sharded_sv_set",
+    sharded_insert<true>)->Unit(benchmark::kMillisecond));
+  //the threads are the benchmark's own, so the timing excludes
+  //starting them
+  int cores = int(std::max(1u, std::thread::hardware_concurrency()));
+  add("sharded_scaling/mutex", sharded_scaling<false>)
+    ->ThreadRange(1, cores)->UseRealTime();
+  add("sharded_scaling/sharded_sv_set", sharded_scaling<true>)
+    ->ThreadRange(1, cores)->UseRealTime();
+}
@@ -0,0 +1,151 @@
+#include "ra/compressed_sv_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+#include <limits>
+
+using namespace ra::container;
+using namespace std;
+
+// Checks every operation of a compressed set built from keys against
+// the sv_set of the same keys.
+template <class T>
+void check_against(const std::vector<T>& keys)
+{
+  sv_set<T> s(keys.begin(), keys.end());
+  compressed_sv_set<T> c(s);
+  assert(c.size() == s.size());
+  assert(std::equal(c.begin(), c.end(), s.begin(), s.end()));
+
+  std::vector<T> probes(keys);
+  for(T k : keys)
+  {
+    probes.push_back(T(k + 1));
+    probes.push_back(T(k - 1));
+  }
+  probes.push_back(0);
+  probes.push_back(std::numeric_limits<T>::max());
+  for(T k : probes)
+  {
+    auto pos = c.lower_bound(k);
+    auto expected = s.lower_bound(k);
+    assert((pos == c.end()) == (expected == s.end()));
+    if(pos != c.end())
+    {
+      assert(*pos == *expected);
+      //the iterator continues from there
+      ++pos;
+      ++expected;
+      assert((pos == c.end()) == (expected == s.end()));
+      assert(pos == c.end() || *pos == *expected);
+    }
+    assert(c.contains(k) == s.contains(k));
+  }
+}
+
+template <class T>
+void compressed_tests()
+{
+  //empty, one key, a partial block, exact blocks
+  check_against<T>({});
+  check_against<T>({T(7)});
+  std::vector<T> keys;
+  for(int i = 0; i < 300; ++i)
+  {
+    keys.push_back(T(i * 3 + 1));
+    if(keys.size() == 128 || keys.size() == 256)
+    {
+      check_against(keys);
+    }
+  }
+  check_against(keys);
+
+  //consecutive keys pack to zero bits
+  std::vector<T> dense(1000);
+  for(std::size_t i = 0; i < dense.size(); ++i)
+  {
+    dense[i] = T(i + 5);
+  }
+  check_against(dense);
+
+  //random gaps of every width, up to the full key range
+  std::mt19937_64 gen(1);
+  std::vector<T> wide;
+  for(int i = 0; i < 5000; ++i)
+  {
+    int bits = i % (8 * sizeof(T));
+    wide.push_back(T(gen() >> (64 - 1 - bits)));
+  }
+  wide.push_back(std::numeric_limits<T>::max());
+  wide.push_back(0);
+  check_against(wide);
+}
+
+void memory_tests()
+{
+  cout << "...Testing compression..." << endl;
+
+  //IDs with an average gap of 16 take about one byte each
+  std::mt19937_64 gen(2);
+  sv_set<std::uint64_t> s;
+  std::vector<std::uint64_t> keys;
+  std::uint64_t id = 1000000;
+  for(int i = 0; i < 100000; ++i)
+  {
+    id += 1 + gen() % 31;
+    keys.push_back(id);
+  }
+  s.insert(keys.begin(), keys.end());
+  compressed_sv_set<std::uint64_t> c(s);
+  assert(c.memory_bytes() * 4 < s.size() * sizeof(std::uint64_t));
+  assert(std::equal(c.begin(), c.end(), s.begin(), s.end()));
+}
+
+void intersect_tests()
+{
+  cout << "...Testing intersection..." << endl;
+
+  std::vector<std::uint32_t> a;
+  std::vector<std::uint32_t> b;
+  for(std::uint32_t i = 0; i < 20000; ++i)
+  {
+    a.push_back(i * 2);
+    if(i % 7 == 0 || (i > 5000 && i < 5300))
+    {
+      b.push_back(i * 3);
+    }
+  }
+  sv_set<std::uint32_t> sa(a.begin(), a.end());
+  sv_set<std::uint32_t> sb(b.begin(), b.end());
+  compressed_sv_set<std::uint32_t> ca(sa);
+  compressed_sv_set<std::uint32_t> cb(sb);
+  std::vector<std::uint32_t> expected;
+  std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(),
+    std::back_inserter(expected));
+  std::vector<std::uint32_t> got;
+  intersect(ca, cb, std::back_inserter(got));
+  assert(got == expected);
+  got.clear();
+  intersect(cb, ca, std::back_inserter(got));
+  assert(got == expected);
+  got.clear();
+  intersect(ca, compressed_sv_set<std::uint32_t>(), std::back_inserter(got));
+  assert(got.empty());
+}
+
+int main()
+{
+  cout << "...Testing compressed set..." << endl;
+  compressed_tests<std::uint64_t>();
+  compressed_tests<std::uint32_t>();
+  compressed_tests<std::uint16_t>();
+  memory_tests();
+  intersect_tests();
+  cout << "Compressed set done" << endl;
+  return 0;
+}
@@ -0,0 +1,134 @@
+#include "ra/concurrent_sv_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace ra::container;
+using namespace std;
+
+template <class T, class Compare = std::less<T>>
+void batch_tests()
+{
+  concurrent_sv_set<T, Compare> s;
+  std::set<T, Compare> expected;
+  assert(s.size() == 0);
+
+  for(int round = 0; round < 20; ++round)
+  {
+    for(int i = 0; i < 200; ++i)
+    {
+      T key = T((round * 7919 + i * 104729) % 1000);
+      if(i % 3 == 0)
+      {
+        s.erase(key);
+        expected.erase(key);
+      }
+      else
+      {
+        s.insert(key);
+        expected.insert(key);
+      }
+    }
+    //nothing is visible before publishing
+    std::size_t before = s.size();
+    assert(s.pending() == 200);
+    s.publish();
+    assert(s.pending() == 0);
+    auto after = s.read();
+    assert(std::equal(after->begin(), after->end(), expected.begin(),
+      expected.end()));
+    assert(before + 200 >= after->size());
+    //the new version is built in storage of exactly its size
+    assert(after->capacity() == after->size());
+  }
+
+  //the last operation on a key wins
+  s.insert(T(5000));
+  s.erase(T(5000));
+  s.erase(T(6000));
+  s.insert(T(6000));
+  s.publish();
+  assert(!s.contains(T(5000)) && s.contains(T(6000)));
+
+  s.update([](auto& set) { set.clear(); });
+  assert(s.size() == 0);
+}
+
+void string_tests()
+{
+  sv_set<std::string> initial;
+  initial.insert("b");
+  concurrent_sv_set<std::string> s(std::move(initial));
+  s.insert("a");
+  s.insert("a string too long for the small string optimization");
+  assert(s.read()->size() == 1 && *s.read()->begin() == "b");
+  s.publish();
+  assert(s.read()->size() == 3);
+}
+
+void thread_tests()
+{
+  cout << "...Testing readers and writers on threads..." << endl;
+
+  //the even keys are never erased; the odd keys come and go
+  concurrent_sv_set<int> s;
+  for(int i = 0; i < 2000; i += 2)
+  {
+    s.insert(i);
+  }
+  s.publish();
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for(int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&, t] {
+      int probe = t;
+      while(!done.load())
+      {
+        auto snap = s.read();
+        assert(std::is_sorted(snap->begin(), snap->end()));
+        assert(snap->contains((probe * 2) % 2000));
+        probe = (probe + 7) % 1000;
+      }
+    });
+  }
+  for(int round = 0; round < 40; ++round)
+  {
+    for(int i = 1; i < 2000; i += 2)
+    {
+      if(round % 2 == 0)
+      {
+        s.insert(i);
+      }
+      else
+      {
+        s.erase(i);
+      }
+    }
+    s.publish();
+    assert(s.size() == (round % 2 == 0 ? 2000u : 1000u));
+  }
+  done = true;
+  for(auto& reader : readers)
+  {
+    reader.join();
+  }
+}
+
+int main()
+{
+  cout << "...Testing batched updates..." << endl;
+  batch_tests<int>();
+  batch_tests<int, std::greater<int>>();
+  string_tests();
+  thread_tests();
+  cout << "Concurrent set done" << endl;
+  return 0;
+}
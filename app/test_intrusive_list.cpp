@@ -14,13 +14,211 @@ struct Widget {
     Widget (int value_ ) : value(value_) {}
     int value;
     ri::list_hook hook;
+    bool operator<(const Widget& other) const { return value < other.value; }
 };
 
 using iterator = ri::slist_iter<Widget,&Widget::hook>;
 
+using widget_list = ri::list<Widget, &Widget::hook>;
+
+// Returns the values in the list, walking it forwards, after checking
+// that walking it backwards visits the same elements.
+std::vector<int> values_of(widget_list& l)
+{
+    std::vector<int> forward;
+    for (auto it = l.begin(); it != l.end(); ++it)
+    {
+        forward.push_back(it->value);
+    }
+    std::vector<int> backward;
+    for (auto it = l.end(); it != l.begin(); )
+    {
+        --it;
+        backward.insert(backward.begin(), it->value);
+    }
+    assert(forward == backward);
+    assert(forward.size() == l.size());
+    return forward;
+}
+
+void splice_tests()
+{
+    std::vector<Widget> storage;
+    for (int i = 0; i < 20; ++i)
+    {
+        storage.push_back(Widget(i));
+    }
+    widget_list a;
+    widget_list b;
+    for (int i = 0; i < 10; ++i)
+    {
+        a.push_back(storage[i]);
+        b.push_front(storage[19 - i]);
+    }
+    assert(a.front().value == 0 && b.front().value == 10);
+    assert(values_of(b) == std::vector<int>({10, 11, 12, 13, 14, 15, 16,
+        17, 18, 19}));
+
+    //all of another list
+    auto pos = a.begin();
+    ++pos;
+    a.splice(pos, b);
+    assert(b.size() == 0 && values_of(b).empty());
+    assert(values_of(a) == std::vector<int>({0, 10, 11, 12, 13, 14, 15, 16,
+        17, 18, 19, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+    a.splice(a.end(), b);
+    assert(a.size() == 20);
+
+    //one element, to another list and within a list
+    b.splice(b.end(), a, a.begin());
+    assert(b.front().value == 0 && a.front().value == 10);
+    a.splice(a.begin(), a, --a.end());
+    a.splice(a.begin(), a, a.begin());
+    assert(a.front().value == 9 && a.back().value == 8 && a.size() == 19);
+
+    //a range, with and without its length
+    auto first = a.begin();
+    auto last = first;
+    std::advance(last, 5);
+    b.splice(b.begin(), a, first, last, 5);
+    assert(values_of(b) == std::vector<int>({9, 10, 11, 12, 13, 0}));
+    assert(a.size() == 14 && a.front().value == 14);
+    first = b.begin();
+    ++first;
+    a.splice(a.end(), b, first, b.end());
+    assert(values_of(b) == std::vector<int>({9}));
+    assert(a.size() == 19 && a.back().value == 0);
+    first = a.begin();
+    last = first;
+    std::advance(last, 6);
+    a.splice(a.end(), a, first, last);
+    assert(values_of(a) == std::vector<int>({1, 2, 3, 4, 5, 6, 7, 8, 10, 11,
+        12, 13, 0, 14, 15, 16, 17, 18, 19}));
+
+    a.pop_front();
+    a.pop_back();
+    assert(a.front().value == 2 && a.back().value == 18 && a.size() == 17);
+
+    //moves and swaps relink the chains
+    widget_list c(std::move(a));
+    assert(a.size() == 0 && values_of(a).empty() && c.size() == 17);
+    c.swap(b);
+    assert(values_of(c) == std::vector<int>({9}));
+    assert(b.size() == 17 && b.front().value == 2);
+    a = std::move(b);
+    assert(b.size() == 0 && a.size() == 17 && values_of(a).back() == 18);
+    const widget_list& ca = a;
+    assert(ca.front().value == 2 && ca.back().value == 18);
+
+    //migrating a long queue is a few pointer writes
+    std::vector<Widget> many(std::size_t(100000), Widget(1));
+    widget_list from;
+    for (auto&& w : many)
+    {
+        from.push_back(w);
+    }
+    widget_list to;
+    auto mid = from.begin();
+    std::advance(mid, 50000);
+    to.splice(to.end(), from, mid, from.end(), 50000);
+    assert(from.size() == 50000 && to.size() == 50000);
+    to.splice(to.begin(), from);
+    assert(from.size() == 0 && to.size() == 100000);
+    assert(&to.front() == &many.front() && &to.back() == &many.back());
+}
+
+// Checks the lengths that a container_stats records for a list.
+void merge_tests()
+{
+    //keys with ties, so that stability shows in the addresses
+    std::vector<Widget> storage;
+    for (int v : {1, 3, 3, 8, 9, 0, 2, 3, 4, 10, 11})
+    {
+        storage.push_back(Widget(v));
+    }
+    widget_list a;
+    widget_list b;
+    for (int i = 0; i < 5; ++i)
+    {
+        a.push_back(storage[i]);
+    }
+    for (int i = 5; i < 11; ++i)
+    {
+        b.push_back(storage[i]);
+    }
+    a.merge(b);
+    assert(b.size() == 0 && values_of(b).empty());
+    assert(values_of(a) == std::vector<int>({0, 1, 2, 3, 3, 3, 4, 8, 9, 10,
+        11}));
+    auto it = a.begin();
+    std::advance(it, 3);
+    assert(&*it == &storage[1] && &*++it == &storage[2]);
+    assert(&*++it == &storage[7]);
+
+    //merging into an empty list, with an empty list, and with itself
+    widget_list c;
+    c.merge(a);
+    assert(a.size() == 0 && c.size() == 11);
+    c.merge(a);
+    c.merge(c);
+    assert(c.size() == 11 && values_of(c).front() == 0);
+
+    //descending order with a comparison object
+    std::vector<Widget> more;
+    for (int v : {12, 7, 5, -1})
+    {
+        more.push_back(Widget(v));
+    }
+    widget_list d;
+    while (c.size() != 0)
+    {
+        Widget& x = c.back();
+        c.pop_back();
+        d.push_back(x);
+    }
+    widget_list e;
+    for (auto& w : more)
+    {
+        e.push_back(w);
+    }
+    auto greater = [](const Widget& x, const Widget& y) {
+        return y.value < x.value;
+    };
+    d.merge(e, greater);
+    assert(values_of(d) == std::vector<int>({12, 11, 10, 9, 8, 7, 5, 4, 3,
+        3, 3, 2, 1, 0, -1}));
+}
+
+void stats_tests()
+{
+    std::vector<Widget> storage(std::size_t(10), Widget(0));
+    ri::list<Widget, &Widget::hook, ra::util::container_stats> values;
+    for (auto&& i : storage)
+    {
+        values.push_back(i);
+    }
+    values.erase(values.begin());
+    values.pop_back();
+    auto snap = values.get_stats().snapshot();
+    assert(snap.size == 8 && snap.peak_size == 10);
+    assert(snap.changes == 12 && snap.lookups == 0);
+    //lengths 8 to 10 fall in the fourth bucket
+    assert(snap.size_histogram[4] == 5);
+    values.clear();
+    assert(values.get_stats().snapshot().size == 0);
+
+    //no statistics, no cost
+    static_assert(sizeof(ri::list<Widget, &Widget::hook>) ==
+        sizeof(ri::list_hook) + sizeof(std::size_t));
+}
+
 
 int main()
 {
+    stats_tests();
+    splice_tests();
+    merge_tests();
+
     std::vector<Widget> storage ;
     storage.push_back(Widget(42));
 
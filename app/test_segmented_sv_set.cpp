@@ -0,0 +1,117 @@
+#include "ra/segmented_sv_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+
+using namespace ra::container;
+using namespace std;
+
+// Checks the elements of s against expected, and that every chunk is
+// sorted, non-empty and within its capacity.
+template <class Set, class Expected>
+void check(const Set& s, const Expected& expected)
+{
+  assert(s.size() == expected.size());
+  assert(std::equal(s.begin(), s.end(), expected.begin(), expected.end()));
+  assert(std::distance(s.begin(), s.end()) == std::ptrdiff_t(s.size()));
+  std::size_t total = 0;
+  for(std::size_t c = 0; c < s.chunk_count(); ++c)
+  {
+    std::size_t n = s.chunk_end(c) - s.chunk_begin(c);
+    assert(n > 0 && n <= Set::chunk_capacity);
+    assert(std::is_sorted(s.chunk_begin(c), s.chunk_end(c), s.key_comp()));
+    total += n;
+  }
+  assert(total == s.size());
+}
+
+template <class T, class Compare = std::less<T>>
+void segmented_tests()
+{
+  segmented_sv_set<T, Compare, 8> s;
+  std::set<T, Compare> expected;
+  assert(s.empty() && s.begin() == s.end());
+  std::mt19937 gen(22);
+
+  //grow with interleaved lookups and erasures
+  for(int i = 0; i < 5000; ++i)
+  {
+    T key = T(gen() % 3000);
+    auto r = s.insert(key);
+    assert(r.second == expected.insert(key).second);
+    assert(*r.first == key);
+    if(i % 3 == 0)
+    {
+      T gone = T(gen() % 3000);
+      assert(s.erase(gone) == expected.erase(gone));
+    }
+    if(i % 10 == 0)
+    {
+      T probe = T(gen() % 3100);
+      assert(s.contains(probe) == (expected.count(probe) != 0));
+      auto lb = s.lower_bound(probe);
+      auto elb = expected.lower_bound(probe);
+      assert((lb == s.end()) == (elb == expected.end()));
+      assert(lb == s.end() || *lb == *elb);
+      auto ub = s.upper_bound(probe);
+      auto eub = expected.upper_bound(probe);
+      assert((ub == s.end()) == (eub == expected.end()));
+      assert(ub == s.end() || *ub == *eub);
+    }
+  }
+  check(s, expected);
+
+  //shrink: chunks are merged as they empty
+  std::size_t chunks = s.chunk_count();
+  while(s.size() > 10)
+  {
+    auto pos = s.begin();
+    std::advance(pos, gen() % s.size());
+    T key = *pos;
+    auto next = s.erase(pos);
+    auto expected_next = expected.erase(expected.find(key));
+    assert((next == s.end()) == (expected_next == expected.end()));
+    assert(next == s.end() || *next == *expected_next);
+  }
+  check(s, expected);
+  assert(s.chunk_count() < chunks / 10);
+
+  //iterate backwards
+  std::vector<T> reversed(std::make_reverse_iterator(s.end()),
+    std::make_reverse_iterator(s.begin()));
+  assert(std::equal(reversed.begin(), reversed.end(), expected.rbegin()));
+
+  //bulk construction
+  std::vector<T> keys;
+  for(int i = 0; i < 1000; ++i)
+  {
+    keys.push_back(T(gen() % 700));
+  }
+  segmented_sv_set<T, Compare, 8> bulk(keys.begin(), keys.end());
+  check(bulk, std::set<T, Compare>(keys.begin(), keys.end()));
+  bulk.insert(keys.begin(), keys.end());
+  check(bulk, std::set<T, Compare>(keys.begin(), keys.end()));
+
+  s.swap(bulk);
+  check(bulk, expected);
+  bulk.clear();
+  assert(bulk.empty() && bulk.chunk_count() == 0 && !bulk.contains(T(1)));
+}
+
+int main()
+{
+  cout << "...Testing segmented_sv_set..." << endl;
+  segmented_tests<int>();
+  segmented_tests<unsigned>();
+  segmented_tests<double, std::greater<double>>();
+  segmented_sv_set<std::string> words{"pear", "apple", "fig", "apple"};
+  assert(words.size() == 3 && *words.begin() == "apple");
+  assert(words.chunk_count() == 1);
+  cout << "segmented_sv_set done" << endl;
+  return 0;
+}
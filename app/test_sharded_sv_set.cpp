@@ -0,0 +1,154 @@
+#include "ra/sharded_sv_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace ra::container;
+using namespace std;
+
+template <class T, class Compare = std::less<T>, std::size_t Shards = 8>
+void shard_tests()
+{
+  sharded_sv_set<T, Compare, Shards> s;
+  std::set<T, Compare> expected;
+  assert(s.empty() && s.begin() == s.end());
+
+  //enough keys to rebalance a few times
+  for(int i = 0; i < 20000; ++i)
+  {
+    T key = T((i * 7919) % 30011);
+    assert(s.insert(key) == expected.insert(key).second);
+    if(i % 101 == 0)
+    {
+      T gone = T((i * 31) % 30011);
+      assert(s.erase(gone) == expected.erase(gone));
+    }
+  }
+  assert(s.size() == expected.size());
+  assert(std::equal(s.begin(), s.end(), expected.begin(), expected.end()));
+  for(int i = 0; i < 31000; i += 13)
+  {
+    assert(s.contains(T(i)) == (expected.count(T(i)) != 0));
+  }
+
+  //the shards are balanced
+  s.rebalance();
+  for(std::size_t i = 0; i < Shards; ++i)
+  {
+    assert(s.shard_size(i) * Shards + Shards >= expected.size());
+    assert(s.shard_size(i) * Shards <= expected.size() + Shards);
+  }
+
+  //range insert
+  std::vector<T> more;
+  for(int i = 0; i < 5000; ++i)
+  {
+    more.push_back(T(40000 + i * 3 % 7000));
+  }
+  s.insert(more.begin(), more.end());
+  expected.insert(more.begin(), more.end());
+  assert(std::equal(s.begin(), s.end(), expected.begin(), expected.end()));
+
+  s.clear();
+  assert(s.empty() && s.begin() == s.end());
+  s.insert(T(1));
+  assert(*s.begin() == T(1) && ++s.begin() == s.end());
+}
+
+void small_tests()
+{
+  //fewer keys than shards never rebalance
+  sharded_sv_set<std::string, std::less<std::string>, 4> s;
+  s.insert("b");
+  s.insert("a");
+  s.rebalance();
+  assert(s.shard_size(0) == 2);
+  assert(*s.begin() == "a");
+
+  sharded_sv_set<int, std::less<int>, 1> one;
+  one.insert(2);
+  one.insert(1);
+  assert(one.size() == 2 && *one.begin() == 1);
+}
+
+void thread_tests()
+{
+  cout << "...Testing inserts on threads..." << endl;
+
+  sharded_sv_set<int> s;
+  std::vector<std::thread> writers;
+  for(int t = 0; t < 4; ++t)
+  {
+    writers.emplace_back([&, t] {
+      for(int i = 0; i < 5000; ++i)
+      {
+        s.insert(i * 4 + t);
+        s.insert(i);
+        assert(s.contains(i * 4 + t));
+      }
+    });
+  }
+  for(auto& writer : writers)
+  {
+    writer.join();
+  }
+  assert(s.size() == 20000);
+  int expected = 0;
+  for(int k : s)
+  {
+    assert(k == expected++);
+  }
+
+  //rebalances while other threads insert ranges, erase and look up,
+  //so that operations retry after the splitters change
+  sharded_sv_set<std::string> words;
+  std::atomic<bool> done{false};
+  std::thread balancer([&] {
+    while(!done.load())
+    {
+      words.rebalance();
+    }
+  });
+  writers.clear();
+  for(int t = 0; t < 4; ++t)
+  {
+    writers.emplace_back([&, t] {
+      for(int i = 0; i < 200; ++i)
+      {
+        std::vector<std::string> batch;
+        for(int j = 0; j < 50; ++j)
+        {
+          batch.push_back(std::to_string(((i * 50 + j) * 4 + t) * 7919 % 100003));
+        }
+        words.insert(batch.begin(), batch.end());
+        assert(words.contains(batch[i % 50]));
+        assert(words.erase(batch[0]) == 1 && !words.contains(batch[0]));
+      }
+    });
+  }
+  for(auto& writer : writers)
+  {
+    writer.join();
+  }
+  done = true;
+  balancer.join();
+  assert(words.size() == 4 * 200 * 49);
+  assert(std::is_sorted(words.begin(), words.end()));
+}
+
+int main()
+{
+  cout << "...Testing sharded set..." << endl;
+  shard_tests<int>();
+  shard_tests<int, std::greater<int>, 16>();
+  small_tests();
+  thread_tests();
+  cout << "Sharded set done" << endl;
+  return 0;
+}
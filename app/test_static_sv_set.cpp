@@ -0,0 +1,91 @@
+#include "ra/static_sv_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ra::container;
+using namespace std;
+
+//built by the compiler: every check below on these is done at
+//compile time
+constexpr static_sv_set<int, 7> primes({13, 2, 7, 3, 17, 5, 11});
+static_assert(primes.size() == 7);
+static_assert(*primes.begin() == 2 && primes.end()[-1] == 17);
+static_assert(primes.contains(11) && !primes.contains(12));
+static_assert(primes.find(1) == primes.end());
+static_assert(*primes.lower_bound(12) == 13);
+static_assert(*primes.upper_bound(13) == 17);
+static_assert(primes.lower_bound(18) == primes.end());
+static_assert(primes.index_of(7) == 3 && primes.index_of(8) == 7);
+
+constexpr auto keywords = make_static_sv_set<std::string_view, std::less<>>(
+  {"while", "if", "else", "for", "return", "break", "continue", "do"});
+static_assert(keywords.contains("for") && !keywords.contains("fo"));
+static_assert(keywords.count("do") == 1);
+static_assert(keywords.index_of(std::string_view("break")) == 0);
+
+constexpr static_sv_set<int, 4, std::greater<int>> descending(
+  std::array<int, 4>{1, 4, 2, 3});
+static_assert(*descending.begin() == 4 && descending.contains(2));
+
+constexpr static_sv_set<int, 0> none(std::array<int, 0>{});
+static_assert(none.empty() && !none.contains(0));
+
+// Checks every lookup in a set of N even keys against
+// std::lower_bound.
+template <std::size_t N>
+void check_sizes()
+{
+  std::array<int, N> keys{};
+  for(std::size_t i = 0; i < N; ++i)
+  {
+    keys[i] = int(2 * (N - i));
+  }
+  static_sv_set<int, N> s(keys);
+  std::sort(keys.begin(), keys.end());
+  assert(std::equal(s.begin(), s.end(), keys.begin(), keys.end()));
+  for(int k = -1; k <= int(2 * N + 2); ++k)
+  {
+    auto expected = std::lower_bound(keys.begin(), keys.end(), k);
+    assert(s.lower_bound(k) - s.begin() == expected - keys.begin());
+    assert(s.contains(k) == (k > 0 && k <= int(2 * N) && k % 2 == 0));
+  }
+}
+
+int main()
+{
+  cout << "...Testing static_sv_set..." << endl;
+  check_sizes<1>();
+  check_sizes<2>();
+  check_sizes<3>();
+  check_sizes<8>();
+  check_sizes<31>();
+  check_sizes<64>();
+  check_sizes<1000>();
+
+  //transparent lookups with run-time strings
+  std::string word = "continue";
+  assert(keywords.contains(word));
+  word.pop_back();
+  assert(!keywords.contains(word));
+
+  //repeated keys are rejected (at run time here; in a constant
+  //expression, this is a compile error)
+  bool thrown = false;
+  try
+  {
+    static_sv_set<int, 3> repeated({1, 2, 1});
+  } catch(const std::invalid_argument&)
+  {
+    thrown = true;
+  }
+  assert(thrown);
+  cout << "static_sv_set done" << endl;
+  return 0;
+}
@@ -0,0 +1,82 @@
+#include "ra/sv_log_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <set>
+
+using namespace ra::container;
+using namespace std;
+
+template <class T, class Compare = std::less<T>>
+void log_set_tests(std::size_t limit)
+{
+  sv_log_set<T, Compare> s(limit);
+  std::set<T, Compare> expected;
+  assert(s.size() == 0);
+  assert(s.begin() == s.end());
+
+  //interleave inserts, repeats, lookups and erases
+  for(int i = 0; i < 3000; ++i)
+  {
+    T key = T((i * 7919) % 2000);
+    assert(s.insert(key) == expected.insert(key).second);
+    assert(s.size() == expected.size());
+    assert(s.buffered() < s.buffer_limit());
+    if(i % 97 == 0)
+    {
+      T gone = T((i * 31) % 2000);
+      assert(s.erase(gone) == expected.erase(gone));
+    }
+    if(i % 10 == 0)
+    {
+      T probe = T((i * 13) % 2100);
+      assert(s.contains(probe) == (expected.count(probe) != 0));
+    }
+  }
+
+  //reading merges the buffer
+  assert(std::equal(s.begin(), s.end(), expected.begin(), expected.end()));
+  assert(s.buffered() == 0);
+  s.insert(T(5000));
+  assert(s.buffered() == (s.buffer_limit() > 1 ? 1u : 0u));
+  assert(s.find(T(5000)) != s.end() && *s.find(T(5000)) == T(5000));
+  assert(s.buffered() == 0);
+  assert(s.find(T(6000)) == s.end());
+
+  s.clear();
+  assert(s.size() == 0);
+}
+
+void limit_tests()
+{
+  //the automatic limit follows the square root of the size
+  sv_log_set<int> s;
+  assert(s.buffer_limit() == 64);
+  for(int i = 0; i < 10000; ++i)
+  {
+    s.insert(i);
+  }
+  s.compact();
+  assert(s.buffer_limit() == 100);
+
+  //explicit limit
+  sv_log_set<std::string> t(2);
+  t.insert("b");
+  assert(t.buffered() == 1);
+  t.insert("a");
+  assert(t.buffered() == 0);
+  assert(*t.begin() == "a");
+}
+
+int main()
+{
+  cout << "...Testing log-structured set..." << endl;
+  log_set_tests<int>(0);
+  log_set_tests<int>(1);
+  log_set_tests<int, std::greater<int>>(16);
+  limit_tests();
+  cout << "Log-structured set done" << endl;
+  return 0;
+}
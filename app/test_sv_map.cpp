@@ -0,0 +1,181 @@
+#include "ra/sv_map.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace ra::container;
+using namespace std;
+
+template <class Map>
+bool same_entries(const Map& m,
+  const std::map<typename Map::key_type, typename Map::mapped_type>& expected)
+{
+  return m.size() == expected.size() && std::equal(m.begin(), m.end(),
+    expected.begin(), [](const auto& a, const auto& b) {
+      return a.first == b.first && a.second == b.second;
+    });
+}
+
+void map_tests()
+{
+  sv_map<int, std::string> m;
+  std::map<int, std::string> expected;
+  assert(m.empty() && m.begin() == m.end());
+
+  //interleave insertions, assignments, lookups and erasures
+  for(int i = 0; i < 2000; ++i)
+  {
+    int key = (i * 7919) % 1500;
+    std::string value = std::to_string(i);
+    auto r = m.try_emplace(key, value);
+    auto e = expected.try_emplace(key, value);
+    assert(r.second == e.second);
+    assert(r.first->first == key && r.first->second == e.first->second);
+    if(i % 5 == 0)
+    {
+      m[key] += "!";
+      expected[key] += "!";
+    }
+    if(i % 41 == 0)
+    {
+      int gone = (i * 31) % 1500;
+      assert(m.erase(gone) == expected.erase(gone));
+    }
+    if(i % 10 == 0)
+    {
+      int probe = (i * 13) % 1600;
+      assert(m.contains(probe) == (expected.count(probe) != 0));
+      assert(m.count(probe) == expected.count(probe));
+    }
+  }
+  assert(same_entries(m, expected));
+
+  //the keys and values are kept in two arrays in the same order
+  assert(std::is_sorted(m.keys().begin(), m.keys().end()));
+  for(std::size_t i = 0; i < m.size(); ++i)
+  {
+    assert(m.values()[i] == expected.at(m.keys().begin()[i]));
+  }
+
+  //operator[] inserts value-initialized values
+  sv_map<std::string, int> counts;
+  for(const char* word : {"b", "a", "c", "a", "b", "a"})
+  {
+    ++counts[word];
+  }
+  assert(counts.size() == 3 && counts["a"] == 3 && counts["b"] == 2);
+  assert(counts.at("c") == 1);
+  bool thrown = false;
+  try
+  {
+    counts.at("d");
+  } catch(const std::out_of_range&)
+  {
+    thrown = true;
+  }
+  assert(thrown && counts.size() == 3);
+
+  //try_emplace does not move from its arguments if the key exists
+  sv_map<int, std::unique_ptr<int>> owners;
+  auto p = std::make_unique<int>(1);
+  assert(owners.try_emplace(1, std::move(p)).second && !p);
+  p = std::make_unique<int>(2);
+  assert(!owners.try_emplace(1, std::move(p)).second && p && *p == 2);
+  assert(*owners.find(1)->second == 1);
+
+  //insert_or_assign
+  assert(!m.insert_or_assign(expected.begin()->first, "x").second);
+  assert(m.find(expected.begin()->first)->second == "x");
+  assert(m.insert_or_assign(-5, "y").second);
+  assert(m.begin()->first == -5 && m.begin()->second == "y");
+
+  //iterator arithmetic and bounds
+  auto it = m.lower_bound(100);
+  assert(it->first >= 100 && (it - 1)->first < 100);
+  assert(m.upper_bound(it->first) == it + 1);
+  assert(m.end() - m.begin() == std::ptrdiff_t(m.size()));
+  sv_map<int, std::string>::const_iterator cit = it;
+  assert(cit == it && cit.key() == it->first);
+  it->second = "changed";
+  assert(m.find(it->first).value() == "changed");
+
+  //erase a range
+  std::size_t n = m.size();
+  auto next = m.erase(m.begin() + 10, m.begin() + 20);
+  assert(m.size() == n - 10 && next == m.begin() + 10);
+  assert(std::is_sorted(m.keys().begin(), m.keys().end()));
+
+  sv_map<int, std::string> other;
+  other.swap(m);
+  assert(m.empty() && other.size() == n - 10);
+  other.clear();
+  assert(other.empty());
+  std::cout << "Map operations done" << std::endl;
+}
+
+void construction_tests()
+{
+  //unsorted pairs; the first of repeated keys is kept
+  std::vector<std::pair<int, int>> pairs;
+  std::map<int, int> expected;
+  for(int i = 0; i < 5000; ++i)
+  {
+    int key = (i * 7919) % 3000;
+    pairs.emplace_back(key, i);
+    expected.emplace(key, i);
+  }
+  sv_map<int, int> m(pairs.begin(), pairs.end());
+  assert(same_entries(m, expected));
+  assert(m.capacity() == m.size());
+
+  sv_map<int, int, std::greater<int>> reversed({{1, 10}, {3, 30}, {2, 20},
+    {3, 31}});
+  assert(reversed.size() == 3 && reversed.begin()->first == 3);
+  assert(reversed.begin()->second == 30);
+
+  std::vector<int> keys = {1, 4, 9};
+  std::vector<std::string> values = {"one", "four", "nine"};
+  sv_map<int, std::string> ordered(
+    sv_map<int, std::string>::ordered_and_unique_range(), keys.begin(),
+    values.begin(), keys.size());
+  assert(ordered.at(4) == "four" && !ordered.contains(5));
+
+  //transparent lookups
+  sv_map<std::string, int, std::less<>> names({{"ada", 1}, {"bob", 2}});
+  std::string_view probe = "bob";
+  assert(names.find(probe)->second == 2);
+  assert(names.contains(std::string_view("ada")));
+  assert(names.count("eve") == 0);
+  assert(names.lower_bound(std::string_view("b"))->first == "bob");
+
+  //other search policies
+  sv_map<std::uint64_t, int, std::less<std::uint64_t>,
+    std::allocator<std::pair<const std::uint64_t, int>>,
+    learned_search_policy<>> learned;
+  for(std::uint64_t i = 0; i < 1000; ++i)
+  {
+    learned[i * i] = int(i);
+  }
+  for(std::uint64_t i = 0; i < 1000; ++i)
+  {
+    assert(learned.at(i * i) == int(i));
+    assert(!learned.contains(i * i + 2));
+  }
+  std::cout << "Map construction done" << std::endl;
+}
+
+int main()
+{
+  cout << "...Testing sv_map..." << endl;
+  map_tests();
+  construction_tests();
+  return 0;
+}
@@ -5,6 +5,17 @@
 #include <cassert>
 #include <functional>
 #include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <limits>
+#include <iterator>
+#include <memory_resource>
+#include <random>
+#include <numeric>
+#include <sstream>
+#include <thread>
 
 using namespace ra::container;
 using namespace std;
@@ -81,9 +92,1101 @@ void constructor_tests()
 
 
 
+template <class T>
+void insert_range_tests()
+{
+  cout << "...Testing range insert..." << endl;
+
+  //insert into an empty set, with repeats and out of order
+  sv_set<T> s1;
+  T vals[8] = {5,3,9,3,1,7,5,0};
+  s1.insert(vals, vals + 8);
+  assert(s1.size() == 6);
+  assert(std::is_sorted(s1.begin(), s1.end()));
+
+  //merge in a batch that overlaps the existing keys
+  s1.insert({2, 9, 4, 1, 8, 6});
+  assert(s1.size() == 10);
+  for(int i = 0; i < 10; ++i)
+  {
+    assert(s1.begin()[i] == T(i));
+  }
+
+  //nothing new, so no growth
+  auto cap = s1.capacity();
+  s1.insert({0, 5, 9});
+  assert(s1.size() == 10);
+  assert(s1.capacity() == cap);
+
+  //empty range
+  s1.insert(vals, vals);
+  assert(s1.size() == 10);
+
+  //keys that go before and after the existing ones
+  sv_set<T, std::greater<T>> s2;
+  s2.insert({10, 20, 30});
+  s2.insert({40, 5, 25, 20});
+  T expected[6] = {40, 30, 25, 20, 10, 5};
+  assert(std::equal(s2.begin(), s2.end(), expected, expected + 6));
+  std::cout << "Range insert done" << std::endl;
+}
+
+template <class T>
+void unsorted_constructor_tests()
+{
+  cout << "...Testing unsorted range constructor..." << endl;
+
+  T vals[8] = {5,3,9,3,1,7,5,0};
+  sv_set<T> s1(vals, vals + 8);
+  assert(s1.size() == 6);
+  assert(s1.capacity() == 8);
+  T expected[6] = {0,1,3,5,7,9};
+  assert(std::equal(s1.begin(), s1.end(), expected, expected + 6));
+
+  //empty range
+  sv_set<T> s2(vals, vals);
+  assert(s2.size() == 0);
+  assert(s2.begin() == s2.end());
+
+  //large range, sorted on several threads
+  std::vector<T> many;
+  for(int i = 0; i < 200000; ++i)
+  {
+    many.push_back(T((i * 7919) % 100000));
+  }
+  sv_set<T> s3(ra::util::parallel_policy{4}, many.begin(), many.end());
+  assert(s3.size() == 100000);
+  for(int i = 0; i < 100000; ++i)
+  {
+    assert(s3.begin()[i] == T(i));
+  }
+  std::cout << "Unsorted constructor done" << std::endl;
+}
+
+void unsorted_string_tests()
+{
+  //keys with non-trivial construction and destruction
+  std::vector<std::string> words = {"pear", "apple", "fig", "apple", "kiwi"};
+  sv_set<std::string> s1(words.begin(), words.end());
+  assert(s1.size() == 4);
+  assert(*s1.begin() == "apple");
+  assert(s1.find("kiwi") != s1.end());
+  s1.insert({"banana", "fig", "cherry"});
+  assert(s1.size() == 6);
+  assert(std::is_sorted(s1.begin(), s1.end()));
+}
+
+template <class T>
+void simd_find_tests()
+{
+  namespace sd = ra::util::simd_detail;
+  static_assert(ra::util::simd_searchable_v<T, std::less<T>>);
+
+  //sizes on both sides of the scan window, odd keys only
+  for(int n = 0; n < 700; n += 7)
+  {
+    std::vector<T> keys;
+    for(int i = 0; i < n; ++i)
+    {
+      keys.push_back(T(2 * i + 1));
+    }
+    sv_set<T> s(typename sv_set<T>::ordered_and_unique_range(),
+      keys.begin(), keys.size());
+    for(int i = 0; i <= 2 * n + 1; ++i)
+    {
+      auto it = s.find(T(i));
+      if(i % 2 == 1 && i < 2 * n)
+      {
+        assert(it != s.end() && *it == T(i));
+      }
+      else
+      {
+        assert(it == s.end());
+      }
+      auto lb = std::lower_bound(keys.data(), keys.data() + n, T(i));
+      assert(ra::util::simd_lower_bound<T>(keys.data(), keys.data() + n,
+        T(i)) == lb);
+    }
+  }
+
+  //each kernel this CPU can run agrees with the scalar one
+  std::vector<T> keys;
+  for(int i = 0; i < 37; ++i)
+  {
+    keys.push_back(T(i * 3));
+  }
+  //keys with the top bit set must compare as unsigned
+  keys.push_back(std::numeric_limits<T>::max() / 2 * 2);
+  for(T k : {T(0), T(1), T(50), T(200), keys.back()})
+  {
+    auto expected = sd::count_less_scalar(keys.data(), keys.size(), k);
+    assert(sd::count_less(keys.data(), keys.size(), k) == expected);
+#ifdef RA_SIMD_SEARCH_X86
+    if(__builtin_cpu_supports("sse4.2"))
+    {
+      assert(sd::count_less_sse4(keys.data(), keys.size(), k) == expected);
+    }
+    if(__builtin_cpu_supports("avx2"))
+    {
+      assert(sd::count_less_avx2(keys.data(), keys.size(), k) == expected);
+    }
+#endif
+  }
+}
+
+template <class T>
+void find_many_tests()
+{
+  cout << "...Testing batched find..." << endl;
+
+  //every third value up to 90000 (too large to take the path for
+  //cache-resident sets)
+  std::vector<T> keys;
+  for(int i = 0; i < 30000; ++i)
+  {
+    keys.push_back(T(3 * i));
+  }
+  sv_set<T> s(keys.begin(), keys.end());
+
+  //unsorted queries with repeats, and the same queries sorted
+  std::vector<T> queries;
+  for(int i = 0; i < 5000; ++i)
+  {
+    queries.push_back(T((i * 7919) % 90100));
+  }
+  std::vector<T> sorted = queries;
+  std::sort(sorted.begin(), sorted.end());
+
+  for(auto* q : {&queries, &sorted})
+  {
+    std::vector<typename sv_set<T>::const_iterator> found;
+    std::vector<bool> present;
+    s.find_many(q->begin(), q->end(), std::back_inserter(found));
+    s.contains_many(q->begin(), q->end(), std::back_inserter(present));
+    assert(found.size() == q->size());
+    assert(present.size() == q->size());
+    for(std::size_t i = 0; i < q->size(); ++i)
+    {
+      assert(found[i] == s.find((*q)[i]));
+      assert(present[i] == (s.find((*q)[i]) != s.end()));
+    }
+  }
+
+  //empty set and empty query range
+  sv_set<T> empty;
+  bool result[4];
+  empty.contains_many(keys.begin(), keys.begin() + 3, result);
+  assert(!result[0] && !result[1] && !result[2]);
+  assert(s.contains_many(keys.begin(), keys.begin(), result) == result);
+
+  //other orderings
+  sv_set<T, std::greater<T>> g(keys.begin(), keys.end());
+  T probes[4] = {T(89997), T(9), T(10), T(0)};
+  g.contains_many(probes, probes + 4, result);
+  assert(result[0] && result[1] && !result[2]);
+  std::cout << "Batched find done" << std::endl;
+}
+
+// A comparator whose order depends on its state.
+struct modulo_less {
+  int modulus;
+  bool operator()(int x, int y) const {
+    return x % modulus < y % modulus;
+  }
+};
+
+// A transparent comparator that counts how often it is called.
+struct counting_less {
+  using is_transparent = void;
+  int* calls;
+  template <class T, class U>
+  bool operator()(const T& x, const U& y) const {
+    ++*calls;
+    return std::less<>()(x, y);
+  }
+};
+
+void lookup_tests()
+{
+  cout << "...Testing lookups..." << endl;
+
+  //stateless comparator and allocator take no space
+  static_assert(sizeof(sv_set<int>) == 3 * sizeof(int*));
+  static_assert(sizeof(sv_set<std::string, std::less<>>) == 3 * sizeof(int*));
+
+  //heterogeneous lookup with a transparent comparator
+  std::vector<std::string> words = {"apple", "fig", "kiwi", "pear"};
+  sv_set<std::string, std::less<>> s1(words.begin(), words.end());
+  std::string_view fig("fig");
+  assert(s1.find(fig) != s1.end() && *s1.find(fig) == "fig");
+  assert(s1.find(std::string_view("grape")) == s1.end());
+  assert(s1.contains(std::string_view("kiwi")));
+  assert(s1.contains("pear"));
+  assert(s1.count(std::string_view("plum")) == 0);
+  assert(*s1.lower_bound(std::string_view("grape")) == "kiwi");
+  assert(*s1.upper_bound(std::string_view("fig")) == "kiwi");
+  auto r = s1.equal_range(std::string_view("kiwi"));
+  assert(r.second - r.first == 1 && *r.first == "kiwi");
+  r = s1.equal_range(std::string_view("lime"));
+  assert(r.first == r.second && *r.first == "pear");
+  const auto& cs1 = s1;
+  assert(cs1.upper_bound(std::string_view("pear")) == cs1.end());
+
+  //the stored comparator is used, not a default-constructed one
+  sv_set<int, modulo_less> s2(modulo_less{10});
+  s2.insert({13, 21, 32, 44});
+  assert(s2.contains(3) && s2.contains(1) && !s2.contains(5));
+  assert(s2.find(23) != s2.end() && *s2.find(23) == 13);
+  assert(!s2.insert(54).second);
+  sv_set<int, modulo_less> s3(s2);
+  assert(s3.key_comp().modulus == 10);
+  assert(*s3.lower_bound(2) == 32 && *s3.upper_bound(2) == 13);
+
+  int calls = 0;
+  sv_set<int, counting_less> s4(counting_less{&calls});
+  s4.insert({1, 2, 3});
+  assert(calls > 0);
+  calls = 0;
+  assert(s4.contains(2L));
+  assert(calls > 0);
+  std::cout << "Lookups done" << std::endl;
+}
+
+// Checks set_union, set_intersection, set_difference and includes
+// on a and b against the std algorithms.
+template <class T, class Compare>
+void check_set_algebra(const sv_set<T, Compare>& a, const sv_set<T, Compare>& b)
+{
+  std::vector<T> expected;
+  std::set_union(a.begin(), a.end(), b.begin(), b.end(),
+    std::back_inserter(expected), Compare());
+  auto u = set_union(a, b);
+  assert(std::equal(u.begin(), u.end(), expected.begin(), expected.end()));
+
+  expected.clear();
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+    std::back_inserter(expected), Compare());
+  auto i = set_intersection(a, b);
+  assert(std::equal(i.begin(), i.end(), expected.begin(), expected.end()));
+
+  expected.clear();
+  std::set_difference(a.begin(), a.end(), b.begin(), b.end(),
+    std::back_inserter(expected), Compare());
+  auto d = set_difference(a, b);
+  assert(std::equal(d.begin(), d.end(), expected.begin(), expected.end()));
+
+  assert(includes(a, b) == std::includes(a.begin(), a.end(), b.begin(),
+    b.end(), Compare()));
+  assert(includes(a, i) && includes(b, i) && includes(u, a));
+}
+
+template <class T, class Compare = std::less<T>>
+void set_algebra_tests()
+{
+  //multiples of step below limit
+  auto multiples = [](int step, int limit) {
+    std::vector<T> keys;
+    for(int k = 0; k < limit; k += step)
+    {
+      if constexpr(std::is_same_v<T, std::string>)
+      {
+        keys.push_back(std::to_string(k));
+      }
+      else
+      {
+        keys.push_back(T(k));
+      }
+    }
+    return sv_set<T, Compare>(keys.begin(), keys.end());
+  };
+
+  sv_set<T, Compare> empty;
+  auto evens = multiples(2, 1000);
+  auto threes = multiples(3, 1000);
+  auto sparse = multiples(97, 1000);
+  check_set_algebra(evens, threes);
+  check_set_algebra(threes, evens);
+  check_set_algebra(evens, sparse);
+  check_set_algebra(sparse, evens);
+  check_set_algebra(evens, empty);
+  check_set_algebra(empty, evens);
+  check_set_algebra(evens, evens);
+
+  //merge into a set with too little room: the other buffer is used
+  auto m1 = multiples(4, 40);
+  m1.shrink_to_fit();
+  auto m2 = multiples(2, 40);
+  m2.reserve(100);
+  const T* buffer = m2.begin();
+  m1.merge(std::move(m2));
+  assert(m1.begin() == buffer);
+  assert(m2.size() == 0);
+  auto expected = multiples(2, 40);
+  assert(std::equal(m1.begin(), m1.end(), expected.begin(), expected.end()));
+
+  //merge into a set with room, and into an empty set
+  auto m3 = multiples(5, 40);
+  m3.reserve(100);
+  m3.merge(multiples(3, 40));
+  assert(std::equal(m3.begin(), m3.end(), set_union(multiples(5, 40),
+    multiples(3, 40)).begin()));
+  sv_set<T, Compare> m4;
+  m4.merge(std::move(m3));
+  assert(m4.size() == 19 && m3.size() == 0);
+}
+
+// An allocator that counts the allocations made through it and
+// that propagates on copy, move and swap.
+template <class T>
+struct counting_allocator {
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit counting_allocator(int* count) : count(count) {}
+  template <class U>
+  counting_allocator(const counting_allocator<U>& other) :
+    count(other.count) {}
+
+  T* allocate(std::size_t n)
+  {
+    ++*count;
+    return std::allocator<T>().allocate(n);
+  }
+  void deallocate(T* p, std::size_t n)
+  {
+    --*count;
+    std::allocator<T>().deallocate(p, n);
+  }
+  template <class U>
+  bool operator==(const counting_allocator<U>& other) const
+    {return count == other.count;}
+  template <class U>
+  bool operator!=(const counting_allocator<U>& other) const
+    {return count != other.count;}
+
+  int* count;
+};
+
+void allocator_tests()
+{
+  cout << "...Testing allocators..." << endl;
+
+  //all storage (including that of the strings) comes from the arena
+  char buffer[4096];
+  std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer),
+    std::pmr::null_memory_resource());
+  {
+    ra::container::pmr::sv_set<std::pmr::string> s(&arena);
+    s.insert(std::pmr::string("a key long enough to need the heap"));
+    s.insert({std::pmr::string("b"), std::pmr::string("c")});
+    assert(s.size() == 3);
+    assert(s.begin()->get_allocator().resource() == &arena);
+    ra::container::pmr::sv_set<std::pmr::string> t(s);
+    assert(t.get_allocator().resource() == std::pmr::get_default_resource());
+  }
+
+  //the scratch buffer of a range insert does not come from the arena,
+  //which has room for the elements only once
+  {
+    alignas(int) char small[1024 * sizeof(int) + 64];
+    std::pmr::monotonic_buffer_resource tight(small, sizeof(small),
+      std::pmr::null_memory_resource());
+    std::vector<int> keys(1000);
+    std::iota(keys.rbegin(), keys.rend(), 0);
+    ra::container::pmr::sv_set<int> s(&tight);
+    s.insert(keys.begin(), keys.end());
+    assert(s.size() == 1000 && s.capacity() == 1000);
+    std::istringstream in("3 1 2");
+    ra::container::pmr::sv_set<int> t(std::istream_iterator<int>(in),
+      std::istream_iterator<int>(), &tight);
+    assert(t.size() == 3);
+  }
+
+  int a = 0;
+  int b = 0;
+  using set = sv_set<int, std::less<int>, counting_allocator<int>>;
+  {
+    set s1{counting_allocator<int>(&a)};
+    s1.insert({1, 2, 3});
+    assert(a > 0);
+    set s2{counting_allocator<int>(&b)};
+    s2.insert(4);
+
+    //copy assignment propagates, releasing the old storage
+    s2 = s1;
+    assert(b == 0);
+    assert(s2.get_allocator() == s1.get_allocator());
+
+    //move assignment and swap take the allocator along
+    set s3{counting_allocator<int>(&b)};
+    s3.insert(5);
+    s3 = std::move(s1);
+    assert(b == 0);
+    assert(s3.size() == 3 && s1.size() == 0);
+    set s4{counting_allocator<int>(&b)};
+    s4.insert(6);
+    s4.swap(s3);
+    assert(*s3.begin() == 6 && s3.get_allocator().count == &b);
+    assert(s4.size() == 3 && s4.get_allocator().count == &a);
+  }
+  assert(a == 0 && b == 0);
+
+  //a non-propagating allocator makes move assignment move elements
+  std::pmr::monotonic_buffer_resource other;
+  ra::container::pmr::sv_set<int> p1(&other);
+  p1.insert({7, 8, 9});
+  ra::container::pmr::sv_set<int> p2(&arena);
+  p2 = std::move(p1);
+  assert(p2.size() == 3 && p1.size() == 0);
+  assert(p2.get_allocator().resource() == &arena);
+  std::cout << "Allocators done" << std::endl;
+}
+
+//checks every lookup in s against std::lower_bound over the elements
+template <class Set>
+void check_search(const Set& s, const std::vector<typename Set::key_type>& probes)
+{
+  for(const auto& k : probes)
+  {
+    auto expected = std::lower_bound(s.begin(), s.end(), k, s.key_comp());
+    assert(s.lower_bound(k) == expected);
+    assert(s.contains(k) == (expected != s.end() && !s.key_comp()(k, *expected)));
+  }
+}
+
+template <class T, class Search>
+void search_policy_tests()
+{
+  using set_type = sv_set<T, std::less<T>, std::allocator<T>, Search>;
+  std::mt19937_64 gen(7);
+  //uniform, clustered and exponentially spaced keys
+  std::vector<std::vector<T>> inputs(3);
+  for(int i = 0; i < 5000; ++i)
+  {
+    inputs[0].push_back(T(gen() % 100000));
+    inputs[1].push_back(T((i / 100) * 10000 + int(gen() % 200)));
+    inputs[2].push_back(T(std::uint64_t(1) << (gen() % 30)) + T(i % 7));
+  }
+  for(auto& keys : inputs)
+  {
+    set_type s(keys.begin(), keys.end());
+    std::vector<T> probes(keys);
+    for(int i = 0; i < 2000; ++i)
+    {
+      probes.push_back(T(gen() % 200000));
+    }
+    probes.push_back(std::numeric_limits<T>::lowest());
+    probes.push_back(std::numeric_limits<T>::max());
+    check_search(s, probes);
+
+    //every change must be seen by the next lookup
+    for(int i = 0; i < 50; ++i)
+    {
+      s.insert(T(gen() % 300000));
+      s.erase(s.begin() + gen() % s.size());
+      check_search(s, probes);
+    }
+    set_type t(s);
+    check_search(t, probes);
+    set_type other;
+    other.insert(probes.begin(), probes.begin() + 100);
+    check_search(other, probes);
+    s.swap(other);
+    check_search(s, probes);
+    check_search(other, probes);
+    t = std::move(s);
+    check_search(t, probes);
+    check_search(s, probes);
+    set_type u(std::move(other));
+    check_search(u, probes);
+    u.merge(std::move(t));
+    check_search(u, probes);
+    u.insert(probes.begin(), probes.end());
+    check_search(u, probes);
+    u.clear();
+    check_search(u, probes);
+  }
+}
+
+void search_policy_tests()
+{
+  search_policy_tests<std::uint64_t, interpolation_search_policy>();
+  search_policy_tests<std::uint64_t, learned_search_policy<>>();
+  search_policy_tests<std::uint64_t, learned_search_policy<1>>();
+  search_policy_tests<int, interpolation_search_policy>();
+  search_policy_tests<int, learned_search_policy<8>>();
+  search_policy_tests<double, interpolation_search_policy>();
+  search_policy_tests<double, learned_search_policy<>>();
+
+  //signed keys on both sides of zero
+  sv_set<long, std::less<long>, std::allocator<long>,
+    learned_search_policy<4>> signed_set;
+  for(long i = -3000; i < 3000; i += 3)
+  {
+    signed_set.insert(i * i * (i < 0 ? -1 : 1));
+  }
+  std::vector<long> probes;
+  for(long i = -10000000; i < 10000000; i += 9973)
+  {
+    probes.push_back(i);
+  }
+  check_search(signed_set, probes);
+  assert(signed_set.get_search_policy().segments() > 1);
+
+  //evenly spaced keys fit in a single segment
+  sv_set<std::uint64_t, std::less<std::uint64_t>,
+    std::allocator<std::uint64_t>, learned_search_policy<>> even;
+  for(std::uint64_t i = 0; i < 10000; ++i)
+  {
+    even.insert(i * 10);
+  }
+  assert(even.get_search_policy().segments() == 0);
+  assert(even.contains(500) && !even.contains(505));
+  assert(even.get_search_policy().segments() == 1);
+  even.insert(5);
+  assert(even.get_search_policy().segments() == 0);
+
+  //keys that cannot be interpolated use a binary search
+  sv_set<std::string, std::less<std::string>,
+    std::allocator<std::string>, learned_search_policy<>> words;
+  words.insert({"pear", "apple", "fig"});
+  assert(words.contains("fig") && !words.contains("kiwi"));
+  assert(words.get_search_policy().segments() == 0);
+
+  //the default policy takes no space
+  static_assert(sizeof(sv_set<int>) == 3 * sizeof(int*));
+}
+
+// A key that counts its moves and live objects, and opts in to
+// trivial relocation.
+struct counted_key {
+  static inline int moves = 0;
+  static inline int live = 0;
+  int value;
+  counted_key(int v) : value(v) { ++live; }
+  counted_key(const counted_key& other) : value(other.value) { ++live; }
+  counted_key(counted_key&& other) noexcept : value(other.value)
+  {
+    ++live;
+    ++moves;
+  }
+  counted_key& operator=(const counted_key&) = default;
+  counted_key& operator=(counted_key&& other) noexcept
+  {
+    value = other.value;
+    ++moves;
+    return *this;
+  }
+  ~counted_key() { --live; }
+  bool operator<(const counted_key& other) const { return value < other.value; }
+};
+
+template <>
+struct ra::container::is_trivially_relocatable<counted_key> :
+  std::true_type {};
+
+// Grows the capacity by a fixed step.
+struct step_growth {
+  std::size_t operator()(std::size_t capacity, std::size_t) const
+  {
+    return capacity + 100;
+  }
+};
+
+void filter_tests()
+{
+  using filtered = filtered_search_policy<>;
+  sv_set<std::uint64_t, std::less<std::uint64_t>,
+    std::allocator<std::uint64_t>, filtered> s;
+  std::mt19937_64 gen(19);
+  std::vector<std::uint64_t> keys;
+  for(int i = 0; i < 20000; ++i)
+  {
+    keys.push_back(gen() | 1);
+  }
+  s.insert(keys.begin(), keys.end());
+  assert(s.get_search_policy().filter_bytes() == 0);
+
+  //no false negatives, and few false positives
+  for(auto k : keys)
+  {
+    assert(s.contains(k));
+  }
+  assert(s.get_search_policy().filter_bytes() ==
+    (keys.size() * filtered::bits_per_key + 511) / 512 * 64);
+  assert(s.get_search_policy().rejections() == 0);
+  const_cast<filtered&>(s.get_search_policy()).reset_counters();
+  std::size_t absent = 100000;
+  for(std::size_t i = 0; i < absent; ++i)
+  {
+    assert(s.find(gen() & ~std::uint64_t(1)) == s.end());
+  }
+  assert(s.get_search_policy().lookups() == absent);
+  assert(s.get_search_policy().rejections() > absent * 97 / 100);
+
+  //once built, the filter may be read from several threads
+  const_cast<filtered&>(s.get_search_policy()).reset_counters();
+  std::vector<std::thread> readers;
+  for(int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&s, t] {
+      for(std::uint64_t i = 0; i < 10000; ++i)
+      {
+        s.contains(i * 8 + t);
+      }
+    });
+  }
+  for(auto& r : readers)
+  {
+    r.join();
+  }
+  assert(s.get_search_policy().lookups() == 40000);
+
+  //single inserts update the filter in place
+  std::size_t bytes = s.get_search_policy().filter_bytes();
+  for(int i = 0; i < 100; ++i)
+  {
+    keys.push_back(gen() | 1);
+    s.insert(keys.back());
+    assert(s.contains(keys.back()));
+  }
+  assert(s.get_search_policy().filter_bytes() == bytes);
+
+  //until the filter is overfull, when it is rebuilt bigger
+  for(int i = 0; i < 30000; ++i)
+  {
+    keys.push_back(gen() | 1);
+    s.insert(keys.back());
+  }
+  for(auto k : keys)
+  {
+    assert(s.contains(k));
+  }
+  assert(s.get_search_policy().filter_bytes() > bytes);
+
+  //erasures drop the filter until the next lookup
+  auto gone = *s.begin();
+  s.erase(s.begin());
+  assert(s.get_search_policy().filter_bytes() == 0);
+  assert(!s.contains(gone) && s.contains(*s.begin()));
+  s.clear();
+  assert(!s.contains(keys[0]));
+
+  //lower_bound does not use the filter
+  s.insert({10, 20, 30});
+  assert(*s.lower_bound(15) == 20 && s.find(15) == s.end());
+
+  //with other key types and inner policies
+  sv_set<std::string, std::less<std::string>, std::allocator<std::string>,
+    filtered_search_policy<16>> words;
+  for(int i = 0; i < 1000; ++i)
+  {
+    words.insert(std::to_string(i * 7));
+  }
+  for(int i = 0; i < 7000; ++i)
+  {
+    assert(words.contains(std::to_string(i)) == (i % 7 == 0));
+  }
+  sv_set<int, std::less<int>, std::allocator<int>,
+    filtered_search_policy<8, learned_search_policy<>>> learned;
+  for(int i = 0; i < 5000; ++i)
+  {
+    learned.insert(i * i % 100003);
+  }
+  std::vector<int> probes(20000);
+  std::iota(probes.begin(), probes.end(), -10);
+  check_search(learned, probes);
+}
+
+// Looks up every key of keys, and its successor, in a set with the
+// search policy Search that collects statistics, and checks that the
+// comparisons counted are the probes the policy reports.
+template <class Search>
+auto stats_probes(const std::vector<std::uint64_t>& keys)
+{
+  sv_set<std::uint64_t, std::less<std::uint64_t>,
+    std::allocator<std::uint64_t>, Search, geometric_growth<>,
+    ra::util::container_stats> s(keys.begin(), keys.end());
+  Search policy;
+  std::size_t probes = 0;
+  for(std::uint64_t k : keys)
+  {
+    for(std::uint64_t q : {k, k + 1})
+    {
+      auto pos = s.lower_bound(q);
+      assert(pos == std::lower_bound(s.begin(), s.end(), q));
+      assert(policy.lower_bound(&*s.begin(), &*s.begin() + s.size(), q,
+        std::less<std::uint64_t>(), probes) == &*pos);
+    }
+  }
+  auto snap = s.get_stats().snapshot();
+  assert(snap.lookups == 2 * keys.size() && snap.comparisons == probes);
+  return s;
+}
+
+// Checks the counters that a container_stats collects for an sv_set.
+void stats_tests()
+{
+  using ra::util::container_stats;
+  using stats_set = sv_set<int, std::less<int>, std::allocator<int>,
+    binary_search_policy, geometric_growth<>, container_stats>;
+
+  //appending moves elements only when the storage grows
+  stats_set s;
+  std::size_t reallocations = 0;
+  std::size_t grown = 0;
+  for(int i = 0; i < 1000; ++i)
+  {
+    if(s.size() == s.capacity())
+    {
+      ++reallocations;
+      grown += s.size();
+    }
+    s.insert(i);
+  }
+  auto snap = s.get_stats().snapshot();
+  assert(snap.reallocations == reallocations);
+  assert(snap.moves == grown && snap.bytes_moved == grown * sizeof(int));
+  assert(snap.size == 1000 && snap.capacity == s.capacity());
+  assert(snap.peak_size == 1000 && snap.peak_capacity == s.capacity());
+  assert(snap.wasted_capacity() == s.capacity() - 1000);
+  assert(snap.lookups == 0);
+
+  //each lookup makes about log2(n) comparisons
+  for(int i = 0; i < 2000; ++i)
+  {
+    assert(s.contains(i) == (i < 1000));
+  }
+  snap = s.get_stats().snapshot();
+  assert(snap.lookups == 2000);
+  assert(snap.comparisons_per_lookup() >= 9 &&
+    snap.comparisons_per_lookup() <= 11);
+  assert(snap.comparison_histogram[4] == 2000);
+
+  //inserting at the front shifts every element
+  s.get_stats().reset();
+  s.insert(-1);
+  snap = s.get_stats().snapshot();
+  assert(snap.moves == 1000 && snap.changes == 1 && snap.lookups == 0);
+  s.erase(s.begin() + 500, s.end());
+  snap = s.get_stats().snapshot();
+  assert(snap.size == 500 && snap.peak_size == 1001);
+  assert(snap.wasted_capacity() == s.capacity() - 500);
+  s.shrink_to_fit();
+  assert(s.get_stats().snapshot().wasted_capacity() == 0);
+
+  //a copy has counters of its own
+  stats_set copy(s);
+  snap = copy.get_stats().snapshot();
+  assert(snap.size == 500 && snap.changes == 1 && snap.lookups == 0);
+
+  //lookups from several threads are all counted
+  std::vector<std::thread> readers;
+  for(int t = 0; t < 4; ++t)
+  {
+    readers.emplace_back([&copy] {
+      for(int i = 0; i < 1000; ++i)
+      {
+        copy.contains(i);
+      }
+    });
+  }
+  for(auto& r : readers)
+  {
+    r.join();
+  }
+  assert(copy.get_stats().snapshot().lookups == 4000);
+
+  //every counter can be exported by name
+  std::vector<std::string> names;
+  copy.get_stats().snapshot().for_each([&](const auto& name, std::uint64_t) {
+    names.push_back(name);
+  });
+  assert(names.size() == 11 + 2 * ra::util::stats_snapshot::buckets);
+  assert(std::find(names.begin(), names.end(), "peak_capacity")
+    != names.end());
+  std::ostringstream dump;
+  dump << copy.get_stats().snapshot();
+  assert(dump.str().find("lookups 4000\n") != std::string::npos);
+  assert(dump.str().find("size_histogram_0 ") == std::string::npos);
+
+  //the results of set algebra record their sizes too, including the
+  //vectorized intersection of uint32_t keys
+  stats_set evens;
+  stats_set thirds;
+  for(int i = 0; i < 600; ++i)
+  {
+    evens.insert(2 * i);
+    thirds.insert(3 * i);
+  }
+  for(const auto& r : {set_union(evens, thirds),
+    set_intersection(evens, thirds), set_difference(evens, thirds)})
+  {
+    snap = r.get_stats().snapshot();
+    assert(snap.size == r.size() && snap.peak_size == r.size());
+    assert(snap.size_histogram[ra::util::stats_snapshot::bucket(r.size())]
+      != 0);
+  }
+  using stats_set32 = sv_set<std::uint32_t, std::less<std::uint32_t>,
+    std::allocator<std::uint32_t>, binary_search_policy, geometric_growth<>,
+    container_stats>;
+  stats_set32 a32;
+  stats_set32 b32;
+  for(std::uint32_t i = 0; i < 600; ++i)
+  {
+    a32.insert(2 * i);
+    b32.insert(3 * i);
+  }
+  stats_set32 both = set_intersection(a32, b32);
+  assert(both.size() == 200);
+  assert(both.get_stats().snapshot().size == 200);
+
+  //lookups with statistics run the search of the policy itself, and
+  //count the probes that it reports
+  std::vector<std::uint64_t> wide;
+  for(std::uint64_t i = 0; i < 100000; ++i)
+  {
+    wide.push_back(i * 7);
+  }
+  stats_probes<binary_search_policy>(wide);
+  stats_probes<interpolation_search_policy>(wide);
+  auto learned_stats = stats_probes<learned_search_policy<>>(wide);
+  assert(learned_stats.get_search_policy().segments() != 0);
+
+  //no statistics, no cost
+  static_assert(sizeof(sv_set<int, std::less<int>, std::allocator<int>,
+    binary_search_policy, geometric_growth<>, ra::util::no_stats>) ==
+    3 * sizeof(int*));
+}
+
+//keys for batch_erase_tests, made from and mapped back to ints
+int key_value(const std::string& x) { return std::stoi(x); }
+int key_value(const counted_key& x) { return x.value; }
+template <class T>
+T make_key(int i)
+{
+  if constexpr(std::is_same_v<T, std::string>)
+  {
+    return std::to_string(i);
+  }
+  else
+  {
+    return T(i);
+  }
+}
+
+template <class T>
+void batch_erase_tests()
+{
+  auto same = [](const T& a, const T& b) { return !(a < b) && !(b < a); };
+  std::mt19937 gen(17);
+  for(int round = 0; round < 20; ++round)
+  {
+    sv_set<T> s;
+    std::vector<T> model;
+    for(int i = 0; i < 1000; ++i)
+    {
+      s.insert(make_key<T>(i * 3));
+      model.push_back(make_key<T>(i * 3));
+    }
+    std::sort(model.begin(), model.end());
+
+    //erase a range
+    std::size_t lo = gen() % s.size();
+    std::size_t hi = lo + gen() % (s.size() - lo + 1);
+    auto it = s.erase(s.begin() + lo, s.begin() + hi);
+    assert(it == s.begin() + lo);
+    model.erase(model.begin() + lo, model.begin() + hi);
+    assert(std::equal(s.begin(), s.end(), model.begin(), model.end(), same));
+
+    //erase a sorted batch, with repeats and keys not in the set
+    std::vector<T> batch;
+    for(int i = 0; i < round * 20; ++i)
+    {
+      batch.push_back(make_key<T>(gen() % 4000));
+    }
+    std::sort(batch.begin(), batch.end());
+    std::size_t expected = 0;
+    for(const T& b : batch)
+    {
+      auto pos = std::lower_bound(model.begin(), model.end(), b);
+      if(pos != model.end() && same(*pos, b))
+      {
+        model.erase(pos);
+        ++expected;
+      }
+    }
+    assert(s.erase_keys(batch.begin(), batch.end()) == expected);
+    assert(std::equal(s.begin(), s.end(), model.begin(), model.end(), same));
+    assert(s.erase_keys(batch.begin(), batch.end()) == 0);
+
+    //erase by predicate
+    int mod = 2 + round % 5;
+    auto pred = [&](const T& x) { return key_value(x) % mod == 0; };
+    std::size_t matching = std::count_if(model.begin(), model.end(), pred);
+    model.erase(std::remove_if(model.begin(), model.end(), pred),
+      model.end());
+    assert(erase_if(s, pred) == matching);
+    assert(std::equal(s.begin(), s.end(), model.begin(), model.end(), same));
+    for(const T& x : model)
+    {
+      assert(s.contains(x));
+    }
+  }
+}
+
+// A batch of keys that are all missing from the set, and all near
+// its end, costs a few comparisons each rather than a search of the
+// whole set each.
+void erase_keys_gallop_tests()
+{
+  int calls = 0;
+  sv_set<int, counting_less> s(counting_less{&calls});
+  std::vector<int> evens(1 << 16);
+  for(int i = 0; i < int(evens.size()); ++i)
+  {
+    evens[i] = 2 * i;
+  }
+  s.insert(evens.begin(), evens.end());
+  int n = int(evens.size());
+  std::vector<int> odds;
+  for(int i = n - 1000; i < n; ++i)
+  {
+    odds.push_back(2 * i + 1);
+  }
+  calls = 0;
+  assert(s.erase_keys(odds.begin(), odds.end()) == 0);
+  assert(calls < 8 * int(odds.size()));
+
+  //with one match in the middle of the batch
+  odds.insert(odds.begin() + 500, 2 * (n - 500));
+  calls = 0;
+  assert(s.erase_keys(odds.begin(), odds.end()) == 1);
+  assert(calls < 8 * int(odds.size()));
+  assert(int(s.size()) == n - 1 && !s.contains(2 * (n - 500)));
+}
+
+void relocation_tests()
+{
+  static_assert(is_trivially_relocatable_v<int>);
+  static_assert(is_trivially_relocatable_v<std::unique_ptr<int>>);
+  static_assert(is_trivially_relocatable_v<std::pair<int, std::shared_ptr<int>>>);
+  static_assert(!is_trivially_relocatable_v<std::string>);
+
+  //relocated keys are neither moved nor destroyed
+  {
+    sv_set<counted_key> s;
+    for(int i = 0; i < 1000; ++i)
+    {
+      const counted_key k((i * 7919) % 1000);
+      s.insert(k);
+    }
+    assert(counted_key::moves == 0);
+    assert(counted_key::live == 1000);
+    for(int i = 0; i < 500; ++i)
+    {
+      s.erase(s.begin() + (i * 31) % s.size());
+    }
+    assert(counted_key::moves == 0);
+    assert(counted_key::live == 500);
+    assert(std::is_sorted(s.begin(), s.end()));
+    s.shrink_to_fit();
+    assert(s.capacity() == 500 && counted_key::live == 500);
+  }
+  assert(counted_key::live == 0);
+
+  //a key moved in is moved once, and never again as the set grows
+  {
+    sv_set<counted_key> s;
+    for(int i = 0; i < 1000; ++i)
+    {
+      s.insert(counted_key((i * 7919) % 1000));
+    }
+    assert(counted_key::moves == 1000);
+    assert(!s.emplace(5).second && s.emplace(1000).second);
+    assert(counted_key::moves == 1001 && counted_key::live == 1001);
+    counted_key::moves = 0;
+  }
+  assert(counted_key::live == 0);
+
+  //move-only keys
+  auto ptr_less = [](const std::unique_ptr<int>& a,
+    const std::unique_ptr<int>& b) { return *a < *b; };
+  sv_set<std::unique_ptr<int>, decltype(ptr_less)> owned(ptr_less);
+  for(int i = 0; i < 300; ++i)
+  {
+    auto p = std::make_unique<int>((i * 37) % 300);
+    int* raw = p.get();
+    auto res = owned.insert(std::move(p));
+    assert(res.second && res.first->get() == raw && p == nullptr);
+  }
+  assert(!owned.emplace(new int(7)).second);
+  assert(owned.size() == 300 && *owned.begin()[299] == 299);
+  owned.erase(owned.begin() + 10);
+  assert(*owned.begin()[10] == 11);
+
+  //relocation keeps the reference counts intact
+  auto deref_less = [](const std::shared_ptr<int>& a,
+    const std::shared_ptr<int>& b) { return *a < *b; };
+  std::vector<std::shared_ptr<int>> owners;
+  {
+    sv_set<std::shared_ptr<int>, decltype(deref_less)> s(deref_less);
+    for(int i = 0; i < 300; ++i)
+    {
+      owners.push_back(std::make_shared<int>((i * 37) % 300));
+      s.insert(owners.back());
+    }
+    s.erase(s.begin() + 10);
+    for(int i = 0; i < 300; ++i)
+    {
+      bool erased = *owners[i] == 10;
+      assert(owners[i].use_count() == (erased ? 1 : 2));
+    }
+    for(int i = 0; i < int(s.size()); ++i)
+    {
+      assert(*s.begin()[i] == (i < 10 ? i : i + 1));
+    }
+  }
+  for(auto& p : owners)
+  {
+    assert(p.use_count() == 1);
+  }
+
+  //growth policies
+  sv_set<int, std::less<int>, std::allocator<int>, binary_search_policy,
+    geometric_growth<3, 2>> slow;
+  std::vector<std::size_t> capacities;
+  for(int i = 0; i < 10; ++i)
+  {
+    slow.insert(i);
+    if(capacities.empty() || capacities.back() != slow.capacity())
+    {
+      capacities.push_back(slow.capacity());
+    }
+  }
+  assert((capacities == std::vector<std::size_t>{1, 2, 4, 7, 11}));
+  sv_set<int, std::less<int>, std::allocator<int>, binary_search_policy,
+    step_growth> stepped;
+  for(int i = 0; i < 150; ++i)
+  {
+    stepped.insert(i);
+  }
+  assert(stepped.capacity() == 200);
+  std::vector<int> many(1000);
+  std::iota(many.begin(), many.end(), 1000);
+  stepped.insert(many.begin(), many.end());
+  assert(stepped.size() == 1150 && stepped.capacity() == 1150);
+  static_assert(sizeof(stepped) == 3 * sizeof(int*));
+}
+
 template <class T> void do_test()
 {
     constructor_tests<T>();
+    insert_range_tests<T>();
+    unsorted_constructor_tests<T>();
+    find_many_tests<T>();
 }
 
 // std::less<T> is a functor class that provides a less-than predicate
@@ -116,6 +1219,38 @@ struct even_then_odd {
 int main()
 {
     do_test<int>();
+    unsorted_string_tests();
+    allocator_tests();
+    lookup_tests();
+    cout << "...Testing set algebra..." << endl;
+    set_algebra_tests<int>();
+    set_algebra_tests<std::uint32_t>();
+    set_algebra_tests<int, std::greater<int>>();
+    set_algebra_tests<std::string>();
+    cout << "Set algebra done" << endl;
+    cout << "...Testing vectorized find..." << endl;
+    simd_find_tests<std::uint32_t>();
+    simd_find_tests<std::uint64_t>();
+    simd_find_tests<double>();
+    cout << "Vectorized find done" << endl;
+    cout << "...Testing search policies..." << endl;
+    search_policy_tests();
+    cout << "Search policies done" << endl;
+    cout << "...Testing relocation and growth..." << endl;
+    relocation_tests();
+    cout << "Relocation and growth done" << endl;
+    cout << "...Testing batched erasure..." << endl;
+    batch_erase_tests<std::string>();
+    batch_erase_tests<counted_key>();
+    erase_keys_gallop_tests();
+    assert(counted_key::live == 0);
+    cout << "Batched erasure done" << endl;
+    cout << "...Testing lookup filters..." << endl;
+    filter_tests();
+    cout << "Lookup filters done" << endl;
+    cout << "...Testing statistics..." << endl;
+    stats_tests();
+    cout << "Statistics done" << endl;
     // cout << "doing less" << endl;
     sv_set<int, std::less<int>> s1;
     
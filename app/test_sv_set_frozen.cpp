@@ -0,0 +1,166 @@
+#include "ra/sv_set_frozen.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <new>
+#include <type_traits>
+
+using namespace ra::container;
+using namespace std;
+
+template <class Layout, class T, class Compare = std::less<T>>
+void check_against_sorted(const std::vector<T>& keys)
+{
+  sv_set<T, Compare> s(keys.begin(), keys.end());
+  sv_set_frozen<T, Compare, Layout> f(s);
+  assert(f.size() == s.size());
+
+  //in-order iteration matches the sorted set
+  assert(std::equal(f.begin(), f.end(), s.begin(), s.end()));
+
+  //every key is found, and lower_bound agrees with the sorted set
+  for(auto&& k : s)
+  {
+    auto it = f.find(k);
+    assert(it != f.end());
+    assert(*it == k);
+    assert(f.contains(k));
+  }
+  for(auto&& k : keys)
+  {
+    T probe = k + 1;
+    auto lb = std::lower_bound(s.begin(), s.end(), probe, Compare());
+    auto it = f.lower_bound(probe);
+    if(lb == s.end())
+    {
+      assert(it == f.end());
+    }
+    else
+    {
+      assert(it != f.end() && *it == *lb);
+    }
+  }
+}
+
+template <class Layout>
+void layout_tests()
+{
+  //empty set
+  sv_set_frozen<int, std::less<int>, Layout> empty;
+  assert(empty.size() == 0);
+  assert(empty.begin() == empty.end());
+  assert(empty.find(3) == empty.end());
+
+  //every size up to a few B-tree levels, with gaps between keys
+  for(int n = 1; n < 300; ++n)
+  {
+    std::vector<int> keys;
+    for(int i = 0; i < n; ++i)
+    {
+      keys.push_back(3 * i);
+    }
+    check_against_sorted<Layout>(keys);
+    assert((!sv_set_frozen<int, std::less<int>, Layout>(
+      sv_set<int>(keys.begin(), keys.end())).contains(-1)));
+  }
+
+  //reverse order and wide keys
+  std::vector<long long> wide;
+  for(long long i = 0; i < 1000; ++i)
+  {
+    wide.push_back(i * 1000003 % 7919);
+  }
+  check_against_sorted<Layout, long long, std::greater<long long>>(wide);
+
+  //copy and move
+  std::vector<int> keys = {4, 8, 15, 16, 23, 42};
+  sv_set_frozen<int, std::less<int>, Layout> f1(
+    sv_set<int>(keys.begin(), keys.end()));
+  auto f2 = f1;
+  auto f3 = std::move(f1);
+  assert(f1.size() == 0);
+  assert(std::equal(f2.begin(), f2.end(), f3.begin(), f3.end()));
+  assert(f3.contains(23) && !f3.contains(24));
+}
+
+//a key whose copies throw once a budget runs out, counting live copies
+struct fragile {
+  static int live;
+  static int budget;
+  int v;
+  fragile(int x) : v(x) { ++live; }
+  fragile(const fragile& other) : v(other.v)
+  {
+    if(budget-- == 0)
+    {
+      throw std::bad_alloc();
+    }
+    ++live;
+  }
+  ~fragile() { --live; }
+  bool operator<(const fragile& other) const { return v < other.v; }
+};
+int fragile::live = 0;
+int fragile::budget = -1;
+
+//a copy that throws part way through the layout destroys exactly the
+//keys already placed, including B-tree padding
+template <class Layout>
+void throwing_copy_tests()
+{
+  std::vector<fragile> keys;
+  for(int i = 0; i < 100; ++i)
+  {
+    keys.emplace_back(i);
+  }
+  //the B-tree pads its last node with copies of the largest key
+  constexpr int ns = int(sv_set_frozen<fragile, std::less<fragile>,
+    btree_layout>::node_size);
+  const int copies = std::is_same_v<Layout, btree_layout> ?
+    (100 + ns - 1) / ns * ns : 100;
+  for(int budget : {0, 1, 37, 99, 100, 101, 110})
+  {
+    fragile::budget = budget;
+    bool thrown = false;
+    try
+    {
+      sv_set_frozen<fragile, std::less<fragile>, Layout> f(
+        sv_set<fragile>::ordered_and_unique_range(), keys.begin(),
+        keys.size());
+      assert(f.size() == 100);
+    } catch(const std::bad_alloc&)
+    {
+      thrown = true;
+    }
+    assert(fragile::live == 100);
+    assert(thrown == (budget < copies));
+  }
+  fragile::budget = -1;
+}
+
+void string_tests()
+{
+  std::vector<std::string> words = {"pear", "apple", "fig", "kiwi", "plum"};
+  sv_set<std::string> s(words.begin(), words.end());
+  sv_set_frozen<std::string, std::less<std::string>, btree_layout> f(s);
+  assert(f.contains("fig"));
+  assert(!f.contains("grape"));
+  assert(*f.lower_bound("grape") == "kiwi");
+  assert(std::equal(f.begin(), f.end(), s.begin(), s.end()));
+}
+
+int main()
+{
+  cout << "...Testing eytzinger layout..." << endl;
+  layout_tests<eytzinger_layout>();
+  cout << "...Testing btree layout..." << endl;
+  layout_tests<btree_layout>();
+  throwing_copy_tests<eytzinger_layout>();
+  throwing_copy_tests<btree_layout>();
+  string_tests();
+  cout << "Frozen set done" << endl;
+  return 0;
+}
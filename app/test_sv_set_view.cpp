@@ -0,0 +1,189 @@
+#include "ra/sv_set_view.hpp"
+#include <iostream>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+
+using namespace ra::container;
+using namespace std;
+
+//with the link option -Wl,--wrap=munmap (see CMakeLists.txt), every
+//munmap call of the views is counted
+static int munmap_calls = 0;
+#ifdef RA_WRAP_MUNMAP
+extern "C" int __real_munmap(void* addr, std::size_t length);
+extern "C" int __wrap_munmap(void* addr, std::size_t length)
+{
+  ++munmap_calls;
+  return __real_munmap(addr, length);
+}
+#endif
+
+template <class T, class Compare = std::less<T>>
+void round_trip_tests(const std::string& path)
+{
+  sv_set<T, Compare> s;
+  for(int i = 0; i < 5000; ++i)
+  {
+    s.insert(T((i * 7919) % 10007));
+  }
+  save(s, path);
+
+  sv_set_view<T, Compare> v(path, true);
+  assert(v.size() == s.size());
+  assert(std::equal(v.begin(), v.end(), s.begin(), s.end()));
+  assert(v.verify());
+  for(int i = 0; i < 10100; i += 7)
+  {
+    auto pos = v.find(T(i));
+    assert((pos != v.end()) == s.contains(T(i)));
+    assert(v.contains(T(i)) == s.contains(T(i)));
+    assert(v.lower_bound(T(i)) - v.begin() ==
+      s.lower_bound(T(i)) - s.begin());
+    assert(v.upper_bound(T(i)) - v.begin() ==
+      s.upper_bound(T(i)) - s.begin());
+  }
+
+  //moving leaves the source empty
+  sv_set_view<T, Compare> w(std::move(v));
+  assert(v.empty() && v.begin() == v.end());
+  assert(w.size() == s.size());
+  v = std::move(w);
+  assert(v.size() == s.size() && w.empty());
+}
+
+void error_tests(const std::string& path)
+{
+  cout << "...Testing invalid files..." << endl;
+
+  sv_set<std::uint32_t> s;
+  s.insert({1, 2, 3});
+  save(s, path);
+
+  //wrong key type
+  bool threw = false;
+  try
+  {
+    sv_set_view<std::uint64_t> v(path);
+  } catch(const std::runtime_error&)
+  {
+    threw = true;
+  }
+  assert(threw);
+
+  //corrupted keys are found only when asked for
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(sizeof(sv_set_file_header));
+    f.put('\x7f');
+  }
+  sv_set_view<std::uint32_t> unchecked(path);
+  assert(!unchecked.verify());
+  threw = false;
+  try
+  {
+    sv_set_view<std::uint32_t> v(path, true);
+  } catch(const std::runtime_error&)
+  {
+    threw = true;
+  }
+  assert(threw);
+
+  //a file with a bad header is unmapped exactly once
+  {
+    std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+    f.put('X');
+  }
+  int calls = munmap_calls;
+  threw = false;
+  try
+  {
+    sv_set_view<std::uint32_t> v(path);
+  } catch(const std::runtime_error&)
+  {
+    threw = true;
+  }
+  assert(threw);
+#ifdef RA_WRAP_MUNMAP
+  assert(munmap_calls == calls + 1);
+#endif
+  (void)calls;
+
+  //truncated file
+  {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    f << "RASVSET";
+  }
+  threw = false;
+  try
+  {
+    sv_set_view<std::uint32_t> v(path);
+  } catch(const std::runtime_error&)
+  {
+    threw = true;
+  }
+  assert(threw);
+
+  //missing file
+  std::remove(path.c_str());
+  threw = false;
+  try
+  {
+    sv_set_view<std::uint32_t> v(path);
+  } catch(const std::system_error&)
+  {
+    threw = true;
+  }
+  assert(threw);
+
+  //concurrent saves to one path each write a file of their own, so
+  //the file left is one of them, whole
+  sv_set<std::uint32_t> big;
+  for(std::uint32_t i = 0; i < 100000; ++i)
+  {
+    big.insert(i * 3);
+  }
+  std::vector<std::thread> savers;
+  for(int t = 0; t < 4; ++t)
+  {
+    savers.emplace_back([&, t] {
+      for(int i = 0; i < 5; ++i)
+      {
+        save(t % 2 ? big : s, path);
+      }
+    });
+  }
+  for(auto& t : savers)
+  {
+    t.join();
+  }
+  sv_set_view<std::uint32_t> saved(path, true);
+  assert(saved.size() == big.size() || saved.size() == s.size());
+
+  //empty set
+  save(sv_set<double>(), path);
+  sv_set_view<double> empty(path, true);
+  assert(empty.size() == 0 && empty.find(1.0) == empty.end());
+  std::remove(path.c_str());
+}
+
+int main()
+{
+  std::string path = "test_sv_set_view.data";
+  cout << "...Testing saved sets..." << endl;
+  round_trip_tests<std::uint32_t>(path);
+  round_trip_tests<std::uint64_t>(path);
+  round_trip_tests<int, std::greater<int>>(path);
+  error_tests(path);
+  cout << "Set view done" << endl;
+  return 0;
+}
@@ -0,0 +1,202 @@
+#include "ra/sv_small_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <new>
+
+using namespace ra::container;
+using namespace std;
+
+template <class T>
+void inline_tests()
+{
+  cout << "...Testing inline storage..." << endl;
+
+  sv_small_set<T, 4> s1;
+  assert(s1.size() == 0);
+  assert(s1.capacity() == 4);
+  assert(s1.is_inline());
+
+  //stays inline up to the inline capacity
+  for(int i : {3, 1, 4, 1, 2})
+  {
+    s1.insert(T(i));
+  }
+  assert(s1.size() == 4);
+  assert(s1.is_inline());
+  assert(std::is_sorted(s1.begin(), s1.end()));
+  assert(s1.contains(T(4)) && !s1.contains(T(5)));
+
+  //spills to the heap
+  s1.insert(T(0));
+  assert(!s1.is_inline());
+  assert(s1.capacity() >= 5);
+  assert(*s1.begin() == T(0));
+
+  //and comes back when it shrinks
+  s1.erase(s1.find(T(0)));
+  s1.erase(s1.find(T(3)));
+  s1.shrink_to_fit();
+  assert(s1.is_inline());
+  assert(s1.size() == 3);
+
+  //large enough for the binary search
+  sv_small_set<T, 2, std::greater<T>> s2;
+  for(int i = 0; i < 100; ++i)
+  {
+    s2.insert(T(i * 37 % 100));
+  }
+  assert(s2.size() == 100);
+  assert(std::is_sorted(s2.begin(), s2.end(), std::greater<T>()));
+  for(int i = 0; i < 100; ++i)
+  {
+    assert(s2.find(T(i)) != s2.end() && *s2.find(T(i)) == T(i));
+  }
+  assert(s2.find(T(100)) == s2.end());
+  assert(!s2.insert(T(5)).second);
+}
+
+template <class T>
+void move_swap_tests()
+{
+  cout << "...Testing move and swap..." << endl;
+
+  //inline source
+  sv_small_set<T, 4> small{T(2), T(1)};
+  sv_small_set<T, 4> m1(std::move(small));
+  assert(small.size() == 0 && small.is_inline());
+  assert(m1.size() == 2 && m1.is_inline());
+
+  //heap source keeps its storage
+  sv_small_set<T, 4> big{T(1), T(2), T(3), T(4), T(5), T(6)};
+  const T* data = big.begin();
+  sv_small_set<T, 4> m2(std::move(big));
+  assert(m2.begin() == data);
+  assert(big.size() == 0 && big.is_inline());
+
+  //swap every combination of inline and heap
+  m1.swap(m2);
+  assert(m1.size() == 6 && m2.size() == 2);
+  assert(m1.begin() == data && m2.is_inline());
+  m2.swap(m1);
+  assert(m2.size() == 6 && m1.size() == 2);
+  sv_small_set<T, 4> m3{T(9)};
+  m1.swap(m3);
+  assert(m1.size() == 1 && m3.size() == 2);
+  sv_small_set<T, 4> m4{T(1), T(2), T(3), T(4), T(5)};
+  m4.swap(m2);
+  assert(m4.size() == 6 && m2.size() == 5);
+
+  //copies
+  sv_small_set<T, 4> c1(m4);
+  assert(std::equal(c1.begin(), c1.end(), m4.begin(), m4.end()));
+  c1 = m3;
+  assert(c1.size() == 2);
+  m3 = std::move(m4);
+  assert(m3.size() == 6 && m4.size() == 0);
+}
+
+//a comparison object with state
+struct ordering {
+  bool descending;
+  bool operator()(int a, int b) const { return descending ? b < a : a < b; }
+};
+
+void compare_tests()
+{
+  cout << "...Testing comparison objects..." << endl;
+
+  sv_small_set<int, 2, ordering> up(ordering{false});
+  sv_small_set<int, 2, ordering> down(ordering{true});
+  for(int i : {2, 3, 1})
+  {
+    up.insert(i);
+    down.insert(i);
+  }
+  assert(*up.begin() == 1 && *down.begin() == 3);
+
+  //swap exchanges the comparison objects with heap storage on both
+  //sides and with inline storage on either side
+  up.swap(down);
+  assert(up.key_comp().descending && !down.key_comp().descending);
+  up.insert(0);
+  assert(*up.begin() == 3 && up.end()[-1] == 0);
+  sv_small_set<int, 2, ordering> one(ordering{false});
+  one.insert(7);
+  one.swap(up);
+  assert(one.key_comp().descending && !up.key_comp().descending);
+  up.insert(8);
+  assert(*up.begin() == 7 && up.contains(8));
+}
+
+//a key whose copies throw once a budget runs out
+struct fragile {
+  static int budget;
+  int v;
+  explicit fragile(int x) : v(x) {}
+  fragile(const fragile& other) : v(other.v)
+  {
+    if(budget-- == 0)
+    {
+      throw std::bad_alloc();
+    }
+  }
+  fragile& operator=(const fragile&) = default;
+  bool operator<(const fragile& other) const { return v < other.v; }
+};
+int fragile::budget = -1;
+
+void throwing_copy_tests()
+{
+  cout << "...Testing throwing copies..." << endl;
+
+  //a copy that fails part way through frees its heap storage (the
+  //leak checker of a sanitized build sees it otherwise)
+  sv_small_set<fragile, 2> s;
+  for(int i = 0; i < 10; ++i)
+  {
+    s.insert(fragile(i));
+  }
+  fragile::budget = 5;
+  bool thrown = false;
+  try
+  {
+    sv_small_set<fragile, 2> copy(s);
+  } catch(const std::bad_alloc&)
+  {
+    thrown = true;
+  }
+  fragile::budget = -1;
+  assert(thrown);
+  sv_small_set<fragile, 2> copy(s);
+  assert(copy.size() == 10);
+}
+
+void string_tests()
+{
+  //non-trivial keys in both storage modes
+  sv_small_set<std::string, 2> s;
+  s.insert("pear");
+  s.insert("apple");
+  sv_small_set<std::string, 2> t(std::move(s));
+  t.insert("a string too long for the small string optimization");
+  t.insert("fig");
+  assert(t.size() == 4);
+  assert(*t.begin() == "a string too long for the small string optimization");
+  sv_small_set<std::string, 2> u{"x"};
+  u.swap(t);
+  assert(u.size() == 4 && t.size() == 1);
+}
+
+int main()
+{
+  inline_tests<int>();
+  move_swap_tests<int>();
+  compare_tests();
+  throwing_copy_tests();
+  string_tests();
+  cout << "Small set done" << endl;
+  return 0;
+}
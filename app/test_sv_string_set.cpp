@@ -0,0 +1,157 @@
+#include "ra/sv_string_set.hpp"
+#include <iostream>
+#include <cassert>
+#include <algorithm>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ra::container;
+using namespace std;
+
+// Returns a random string over a small alphabet (so that strings
+// often share prefixes), which may hold '\0' and bytes above 0x7f.
+std::string random_string(std::mt19937& gen)
+{
+  static const char alphabet[] = {'a', 'b', '.', '/', '\0', '\xff'};
+  std::string s = gen() % 2 ? "https://www." : "";
+  std::size_t n = gen() % 20;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    s += alphabet[gen() % sizeof(alphabet)];
+  }
+  return s;
+}
+
+bool same_strings(const sv_string_set& s, const std::set<std::string>& expected)
+{
+  return s.size() == expected.size() &&
+    std::equal(s.begin(), s.end(), expected.begin());
+}
+
+void string_set_tests()
+{
+  std::mt19937 gen(21);
+  sv_string_set s;
+  std::set<std::string> expected;
+  assert(s.empty() && s.begin() == s.end());
+
+  //interleave inserts, lookups and erasures
+  for(int i = 0; i < 20000; ++i)
+  {
+    std::string key = random_string(gen);
+    auto r = s.insert(key);
+    assert(r.second == expected.insert(key).second);
+    assert(*r.first == key);
+    if(i % 3 == 0)
+    {
+      std::string gone = random_string(gen);
+      assert(s.erase(gone) == expected.erase(gone));
+    }
+    if(i % 10 == 0)
+    {
+      std::string probe = random_string(gen);
+      assert(s.contains(probe) == (expected.count(probe) != 0));
+      auto lb = s.lower_bound(probe);
+      auto elb = expected.lower_bound(probe);
+      assert(lb - s.begin() == std::distance(expected.begin(), elb));
+      auto ub = s.upper_bound(probe);
+      auto eub = expected.upper_bound(probe);
+      assert(ub - s.begin() == std::distance(expected.begin(), eub));
+    }
+  }
+  assert(same_strings(s, expected));
+  //erased strings leave at most half the arena unused
+  std::size_t bytes = 0;
+  for(const auto& x : expected)
+  {
+    bytes += x.size();
+  }
+  assert(s.arena_size() <= 2 * bytes + 32);
+  s.shrink_to_fit();
+  assert(s.arena_size() == bytes);
+  assert(same_strings(s, expected));
+
+  //lookups from std::string, C strings and string_views
+  sv_string_set words{"pear", "apple", "fig", "apple", "applesauce",
+    "apples"};
+  assert(words.size() == 5);
+  assert(words.contains(std::string("fig")) && words.contains("pear"));
+  assert(!words.contains(std::string_view("appl")));
+  assert(*words.begin() == "apple" && words.begin()[1] == "apples");
+  assert(words.find("applesauce")->size() == 10);
+  assert(*words.lower_bound("b") == "fig");
+  assert(words.upper_bound("pear") == words.end());
+
+  //strings that differ only after the prefix, or by a trailing '\0'
+  sv_string_set close{std::string_view("abcdefgh"),
+    std::string_view("abcdefgh\0", 9), std::string_view("abcdefghi"),
+    std::string_view("abcdefg")};
+  assert(close.size() == 4);
+  assert(close.begin()[0] == "abcdefg" && close.begin()[1] == "abcdefgh");
+  assert(close.begin()[2] == std::string_view("abcdefgh\0", 9));
+  assert(close.contains(std::string_view("abcdefgh\0", 9)));
+  assert(!close.contains(std::string_view("abcdefg\0", 8)));
+
+  //bulk construction from unsorted strings
+  std::vector<std::string> many;
+  for(int i = 0; i < 5000; ++i)
+  {
+    many.push_back(random_string(gen));
+  }
+  sv_string_set bulk(many.begin(), many.end());
+  assert(same_strings(bulk, std::set<std::string>(many.begin(),
+    many.end())));
+
+  //prefixes taken from the set's own strings, which grow the arena
+  //while they still view it
+  sv_string_set own{"https://www.example.com/index", "ftp.example.org"};
+  own.shrink_to_fit();
+  for(std::size_t n = 1; n <= 8; ++n)
+  {
+    std::string_view url = *own.find("https://www.example.com/index");
+    std::string expect(url.substr(0, n));
+    auto r = own.insert(url.substr(0, n));
+    assert(r.second && *r.first == expect);
+  }
+  assert(own.contains("https://") && own.contains("h"));
+  assert(own.contains("https://www.example.com/index"));
+
+  //bulk construction from iterators that return strings by value
+  std::vector<int> numbers{3, 141, 59, 26, 141};
+  auto to_string = [](int n) { return std::string(40, 'x') + std::to_string(n); };
+  std::vector<std::string> spelled;
+  for(int n : numbers)
+  {
+    spelled.push_back(to_string(n));
+  }
+  struct by_value
+  {
+    std::vector<int>::const_iterator it;
+    decltype(to_string) f;
+    std::string operator*() const { return f(*it); }
+    by_value& operator++() { ++it; return *this; }
+    bool operator!=(const by_value& o) const { return it != o.it; }
+  };
+  sv_string_set generated(by_value{numbers.cbegin(), to_string},
+    by_value{numbers.cend(), to_string});
+  assert(same_strings(generated, std::set<std::string>(spelled.begin(),
+    spelled.end())));
+
+  sv_string_set other;
+  other.swap(bulk);
+  assert(bulk.empty() && other.size() != 0);
+  other.clear();
+  assert(other.empty() && !other.contains(many[0]));
+  std::cout << "sv_string_set done" << std::endl;
+}
+
+int main()
+{
+  cout << "...Testing sv_string_set..." << endl;
+  string_set_tests();
+  return 0;
+}
@@ -0,0 +1,416 @@
+#ifndef compressed_sv_set_hpp
+#define compressed_sv_set_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include "ra/sv_set.hpp"
+#include "ra/simd_search.hpp"
+
+namespace ra::container {
+
+namespace detail {
+
+// Returns the n-th width-bit field of the bit stream at base.
+// The word after the field must be readable.
+inline std::uint64_t unpack_field(const std::uint64_t* base, std::size_t n,
+  unsigned width) noexcept
+{
+  std::size_t bit = n * width;
+  std::size_t word = bit / 64;
+  unsigned shift = bit % 64;
+  //two shifts, so that a shift of zero does not shift by 64
+  std::uint64_t v = (base[word] >> shift) |
+    ((base[word + 1] << 1) << (63 - shift));
+  return width == 64 ? v : v & ((std::uint64_t(1) << width) - 1);
+}
+
+// Writes to out[i] the value first + i + d[i] for i in [0, n), where
+// d is the stream of width-bit fields at base.
+inline void unpack_block_scalar(const std::uint64_t* base, std::size_t n,
+  unsigned width, std::uint64_t first, std::uint64_t* out) noexcept
+{
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    out[i] = first + i + unpack_field(base, i, width);
+  }
+}
+
+#ifdef RA_SIMD_SEARCH_X86
+
+// As above, four fields at a time, which are gathered and shifted
+// into place lane by lane.
+__attribute__((target("avx2")))
+inline void unpack_block_avx2(const std::uint64_t* base, std::size_t n,
+  unsigned width, std::uint64_t first, std::uint64_t* out) noexcept
+{
+  const long long* words = reinterpret_cast<const long long*>(base);
+  const __m256i mask = _mm256_set1_epi64x(width == 64 ? -1LL :
+    static_cast<long long>((std::uint64_t(1) << width) - 1));
+  const __m256i sixty_three = _mm256_set1_epi64x(63);
+  const __m256i sixty_four = _mm256_set1_epi64x(64);
+  const __m256i four = _mm256_set1_epi64x(4);
+  const __m256i step = _mm256_set1_epi64x(4 * static_cast<long long>(width));
+  __m256i bits = _mm256_set_epi64x(3 * width, 2 * width, width, 0);
+  __m256i offset = _mm256_add_epi64(_mm256_set1_epi64x(
+    static_cast<long long>(first)), _mm256_set_epi64x(3, 2, 1, 0));
+  std::size_t i = 0;
+  for(; i + 4 <= n; i += 4)
+  {
+    __m256i word = _mm256_srli_epi64(bits, 6);
+    __m256i shift = _mm256_and_si256(bits, sixty_three);
+    __m256i lo = _mm256_i64gather_epi64(words, word, 8);
+    __m256i hi = _mm256_i64gather_epi64(words + 1, word, 8);
+    //a shift count of 64 gives zero
+    __m256i v = _mm256_or_si256(_mm256_srlv_epi64(lo, shift),
+      _mm256_sllv_epi64(hi, _mm256_sub_epi64(sixty_four, shift)));
+    v = _mm256_add_epi64(_mm256_and_si256(v, mask), offset);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    bits = _mm256_add_epi64(bits, step);
+    offset = _mm256_add_epi64(offset, four);
+  }
+  for(; i < n; ++i)
+  {
+    out[i] = first + i + unpack_field(base, i, width);
+  }
+}
+
+#endif
+
+}
+
+// A read-only set of unique unsigned integers that stores its keys
+// compressed, for large sets of sorted IDs.
+// The keys are split into blocks of block_size keys. Each block
+// keeps its first key in a skip index, and stores key i of the block
+// as key - first - i (frame of reference, less the position),
+// bit-packed at the smallest width that holds the largest such
+// value. Dense sets of IDs thus take one or two bytes per key
+// instead of sizeof(UInt), and runs of consecutive IDs take none.
+// Any key of a block can be unpacked on its own, so a lookup
+// binary-searches the skip index and then the packed block, without
+// decoding it. Whole blocks are decoded (with AVX2 when the CPU has
+// it) only by intersect.
+template <class UInt >
+class compressed_sv_set {
+public:
+
+  static_assert(std::is_integral_v<UInt> && std::is_unsigned_v<UInt> &&
+    sizeof(UInt) <= 8, "keys must be unsigned integers of up to 64 bits");
+
+  using value_type = UInt ;
+  using key_type = UInt ;
+  using key_compare = std::less<UInt>;
+  using size_type = std::size_t;
+
+  // The number of keys in each block.
+  static constexpr size_type block_size = 128;
+
+  // The non-mutable (forward) iterator type for the container.
+  // Elements are visited in sorted order. Dereferencing yields a
+  // value, since the keys are not stored as such.
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = UInt;
+    using difference_type = std::ptrdiff_t;
+    using reference = UInt;
+    using pointer = const UInt*;
+
+    const_iterator() : set_(nullptr), pos_(0) {}
+
+    reference operator*() const
+    {
+      return static_cast<UInt>(set_->key_at(pos_));
+    }
+
+    const_iterator& operator++()
+    {
+      ++pos_;
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator old(*this);
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator& other) const
+      {return pos_ == other.pos_;}
+    bool operator!=(const const_iterator& other) const
+      {return !(*this == other);}
+
+  private:
+    friend class compressed_sv_set;
+    const_iterator(const compressed_sv_set* set, size_type pos) :
+      set_(set), pos_(pos) {}
+
+    const compressed_sv_set* set_;
+    //index of the element in sorted order
+    size_type pos_;
+  };
+  using iterator = const_iterator;
+
+  // Creates an empty set.
+  compressed_sv_set () : size_(0), words_(2, 0) {}
+
+  // Creates a set containing the elements of the sorted set s.
+  template <class Allocator , class... Policies >
+  explicit compressed_sv_set (
+  const sv_set<UInt, std::less<UInt>, Allocator, Policies...>& s ) :
+    compressed_sv_set(typename sv_set<UInt>::ordered_and_unique_range(),
+      s.begin(), s.size()) {}
+
+  // Creates a set containing the elements specified by the range
+  // [first, first + n), which must be both ordered (ascending) and
+  // unique. Otherwise, the behavior is undefined.
+  template <class InputIterator >
+  compressed_sv_set (typename sv_set<UInt>::ordered_and_unique_range ,
+  InputIterator first , size_type n ) : size_(n)
+  {
+    size_type blocks = (n + block_size - 1) / block_size;
+    firsts_.reserve(blocks);
+    offsets_.reserve(blocks);
+    widths_.reserve(blocks);
+    std::uint64_t keys[block_size];
+    for(size_type b = 0; b < blocks; ++b)
+    {
+      size_type count = std::min(block_size, n - b * block_size);
+      for(size_type i = 0; i < count; ++i, ++first)
+      {
+        keys[i] = static_cast<std::uint64_t>(*first);
+      }
+      //the stored values never decrease, so the last is the largest
+      std::uint64_t largest = keys[count - 1] - keys[0] - (count - 1);
+      unsigned width = 0;
+      while(width < 64 && (largest >> width) != 0)
+      {
+        ++width;
+      }
+      firsts_.push_back(static_cast<UInt>(keys[0]));
+      offsets_.push_back(words_.size());
+      widths_.push_back(static_cast<unsigned char>(width));
+      if(width == 0)
+      {
+        continue;
+      }
+      words_.resize(words_.size() + (count * width + 63) / 64, 0);
+      std::uint64_t* base = words_.data() + offsets_.back();
+      size_type bit = 0;
+      for(size_type i = 0; i < count; ++i, bit += width)
+      {
+        std::uint64_t v = keys[i] - keys[0] - i;
+        base[bit / 64] |= v << (bit % 64);
+        if(bit % 64 + width > 64)
+        {
+          base[bit / 64 + 1] |= v >> (64 - bit % 64);
+        }
+      }
+    }
+    //the decoders read up to two words past the end of a block
+    words_.resize(words_.size() + 2, 0);
+    words_.shrink_to_fit();
+  }
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return key_compare();
+  }
+
+  // Returns the number of elements in the set.
+  size_type size () const noexcept
+  {
+    return size_;
+  }
+
+  bool empty () const noexcept
+  {
+    return size_ == 0;
+  }
+
+  // Returns the number of bytes of storage used by the elements,
+  // including the skip index.
+  size_type memory_bytes () const noexcept
+  {
+    return firsts_.capacity() * sizeof(UInt) +
+      offsets_.capacity() * sizeof(size_type) + widths_.capacity() +
+      words_.capacity() * sizeof(std::uint64_t);
+  }
+
+  const_iterator begin () const noexcept
+  {
+    return const_iterator(this, 0);
+  }
+
+  const_iterator end () const noexcept
+  {
+    return const_iterator(this, size_);
+  }
+
+  // Returns an iterator referring to the first element that is not
+  // less than k, or end() if there is no such element.
+  const_iterator lower_bound (const key_type& k) const
+  {
+    size_type b = std::upper_bound(firsts_.begin(), firsts_.end(), k) -
+      firsts_.begin();
+    if(b == 0)
+    {
+      return begin();
+    }
+    --b;
+    //branchless binary search over the packed keys of block b
+    size_type pos = b * block_size;
+    size_type n = std::min(block_size, size_ - pos);
+    const std::uint64_t* base = words_.data() + offsets_[b];
+    unsigned width = widths_[b];
+    std::uint64_t target = std::uint64_t(k) - firsts_[b];
+    size_type i = 0;
+    while(n > 1)
+    {
+      size_type half = n / 2;
+      size_type mid = i + half - 1;
+      i = (mid + detail::unpack_field(base, mid, width) < target) ?
+        i + half : i;
+      n -= half;
+    }
+    i += (i + detail::unpack_field(base, i, width) < target);
+    return const_iterator(this, pos + i);
+  }
+
+  // Searches the container for an element with the key k.
+  // If an element is found, an iterator referencing the element
+  // is returned; otherwise, end() is returned.
+  const_iterator find (const key_type& k) const
+  {
+    const_iterator pos = lower_bound(k);
+    return (pos != end() && *pos == k) ? pos : end();
+  }
+
+  // Returns true if the set holds an element with the key k.
+  bool contains (const key_type& k) const
+  {
+    return find(k) != end();
+  }
+
+  // Writes to out the elements that are in both a and b, in
+  // ascending order, and returns the end of the output.
+  // Only blocks whose key ranges overlap are decoded.
+  template <class OutputIterator >
+  friend OutputIterator intersect (const compressed_sv_set& a ,
+  const compressed_sv_set& b , OutputIterator out )
+  {
+    std::uint64_t ka[block_size];
+    std::uint64_t kb[block_size];
+    size_type na = 0;
+    size_type nb = 0;
+    size_type decoded_a = a.blocks();
+    size_type decoded_b = b.blocks();
+    size_type i = 0;
+    size_type j = 0;
+    while(i < a.blocks() && j < b.blocks())
+    {
+      std::uint64_t max_a = a.block_max(i);
+      std::uint64_t max_b = b.block_max(j);
+      if(max_a < b.firsts_[j])
+      {
+        ++i;
+        continue;
+      }
+      if(max_b < a.firsts_[i])
+      {
+        ++j;
+        continue;
+      }
+      if(decoded_a != i)
+      {
+        na = a.decode(i, ka);
+        decoded_a = i;
+      }
+      if(decoded_b != j)
+      {
+        nb = b.decode(j, kb);
+        decoded_b = j;
+      }
+      size_type x = 0;
+      size_type y = 0;
+      while(x < na && y < nb)
+      {
+        if(ka[x] < kb[y])
+        {
+          ++x;
+        }
+        else if(kb[y] < ka[x])
+        {
+          ++y;
+        }
+        else
+        {
+          *out++ = static_cast<UInt>(ka[x]);
+          ++x;
+          ++y;
+        }
+      }
+      i += max_a <= max_b;
+      j += max_b <= max_a;
+    }
+    return out;
+  }
+
+private:
+  //first key of each block
+  std::vector<UInt> firsts_;
+  //word offset of the packed keys of each block
+  std::vector<size_type> offsets_;
+  //bit width of the packed keys of each block
+  std::vector<unsigned char> widths_;
+  size_type size_;
+  //packed keys, plus two words of padding
+  std::vector<std::uint64_t> words_;
+
+  size_type blocks() const noexcept
+  {
+    return firsts_.size();
+  }
+
+  //returns the element at index pos in sorted order
+  std::uint64_t key_at(size_type pos) const noexcept
+  {
+    size_type b = pos / block_size;
+    size_type i = pos % block_size;
+    return std::uint64_t(firsts_[b]) + i +
+      detail::unpack_field(words_.data() + offsets_[b], i, widths_[b]);
+  }
+
+  //returns the largest key of block b
+  std::uint64_t block_max(size_type b) const noexcept
+  {
+    return key_at(std::min(size_, (b + 1) * block_size) - 1);
+  }
+
+  //writes the keys of block b to out, and returns their number
+  size_type decode(size_type b, std::uint64_t* out) const noexcept
+  {
+    size_type count = std::min(block_size, size_ - b * block_size);
+    const std::uint64_t* base = words_.data() + offsets_[b];
+#ifdef RA_SIMD_SEARCH_X86
+    if(ra::util::simd_detail::detected_isa() ==
+      ra::util::simd_detail::isa::avx2)
+    {
+      detail::unpack_block_avx2(base, count, widths_[b], firsts_[b], out);
+      return count;
+    }
+#endif
+    detail::unpack_block_scalar(base, count, widths_[b], firsts_[b], out);
+    return count;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,313 @@
+#ifndef concurrent_sv_set_hpp
+#define concurrent_sv_set_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "ra/grace_period.hpp"
+#include "ra/sv_set.hpp"
+
+namespace ra::container {
+
+// A set of unique elements for read-mostly use by many threads,
+// using read-copy-update.
+// The elements live in an immutable sv_set (a version), which is
+// published through an atomic pointer. Readers take a snapshot of
+// the current version without any lock or retry, and may use it for
+// as long as they hold the snapshot. Writers queue insertions and
+// erasures, and publish() applies them all to a copy of the current
+// version, publishes the copy and then frees the old version once no
+// snapshot can still refer to it.
+// Reclamation uses a ra::util::grace_period, whose reader counts are
+// striped so that readers on different threads do not write to the
+// same cache line.
+template <class Key , class Compare = std::less<Key>,
+  class Allocator = std::allocator<Key>>
+class concurrent_sv_set {
+public:
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using allocator_type = Allocator ;
+  using size_type = std::size_t;
+
+  // The type of a version of the set.
+  using base_set = sv_set<Key, Compare, Allocator>;
+
+  // The number of stripes of each reader count.
+  static constexpr size_type reader_stripes = ra::util::grace_period::stripes;
+
+  // A read-only reference to the version of the set that was current
+  // when the snapshot was taken. The version is kept alive until the
+  // snapshot is destroyed, so iterators and pointers obtained from it
+  // remain valid until then. A snapshot must not outlive its set,
+  // and should be held only briefly, since it delays the writers. A
+  // thread that holds a snapshot must not call publish() or update(),
+  // which would wait for it forever.
+  class snapshot {
+  public:
+
+    snapshot ( snapshot && other ) noexcept = default;
+
+    snapshot (const snapshot&) = delete;
+    snapshot& operator=(const snapshot&) = delete;
+    snapshot& operator=(snapshot&&) = delete;
+
+    const base_set& operator*() const noexcept { return *set_; }
+    const base_set* operator->() const noexcept { return set_; }
+
+  private:
+    friend class concurrent_sv_set;
+
+    snapshot ( ra::util::grace_period::guard guard ,
+      const base_set* set ) noexcept : guard_(std::move(guard)), set_(set) {}
+
+    ra::util::grace_period::guard guard_;
+    const base_set* set_;
+  };
+
+  // Creates an empty set.
+  explicit concurrent_sv_set (const Allocator& alloc = Allocator()) :
+    current_(new base_set(alloc)), pending_(alloc) {}
+
+  // Creates a set whose first version holds the elements of s.
+  explicit concurrent_sv_set ( base_set s ) :
+    current_(new base_set(std::move(s))),
+    pending_(current_.load()->get_allocator()) {}
+
+  // Do not allow the copying or moving of sets.
+  concurrent_sv_set (const concurrent_sv_set&) = delete;
+  concurrent_sv_set& operator=(const concurrent_sv_set&) = delete;
+
+  // Destroys the set. No snapshot may still exist.
+  ~concurrent_sv_set()
+  {
+    delete current_.load();
+  }
+
+  // Returns a snapshot of the current version.
+  // This never blocks.
+  snapshot read () const noexcept
+  {
+    auto guard = readers_.enter();
+    return snapshot(std::move(guard), current_.load());
+  }
+
+  // Returns true if the current version holds an element with the
+  // key k.
+  bool contains (const key_type & k ) const
+  {
+    return read()->contains(k);
+  }
+
+  // Returns the number of elements in the current version.
+  size_type size () const
+  {
+    return read()->size();
+  }
+
+  // Queues the insertion of x. It becomes visible to readers at the
+  // next call to publish().
+  void insert (const key_type & x )
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    pending_.emplace_back(x, true);
+  }
+
+  // Queues the erasure of the element with the key k, if any. It
+  // becomes visible to readers at the next call to publish().
+  void erase (const key_type & k )
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    pending_.emplace_back(k, false);
+  }
+
+  // Returns the number of queued insertions and erasures.
+  size_type pending () const
+  {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return pending_.size();
+  }
+
+  // Applies the queued insertions and erasures, in the order they
+  // were queued, and publishes the result as a new version.
+  // The new version is built in one merge pass over the current
+  // version. Blocks until the old version is no longer referred to
+  // by any snapshot, and then frees it. Operations queued meanwhile
+  // wait for the next call.
+  void publish ()
+  {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    publish_pending();
+  }
+
+  // Publishes f(s) as a new version, where s is a copy of the current
+  // version, after publishing any queued operations. f takes a
+  // base_set& and may change it in any way.
+  // Blocks until the old version is no longer referred to by any
+  // snapshot, and then frees it.
+  template <class F >
+  void update ( F f )
+  {
+    std::lock_guard<std::mutex> lock(publish_mutex_);
+    publish_pending();
+    std::unique_ptr<base_set> next(new base_set(*current_.load()));
+    f(*next);
+    retire(current_.exchange(next.release()));
+  }
+
+private:
+  using operation = std::pair<Key, bool>;
+  using operation_allocator = typename std::allocator_traits<Allocator>::
+    template rebind_alloc<operation>;
+
+  //an input iterator over the elements of a version with a sorted
+  //batch of operations applied, where every erasure names an element
+  //of the version and no insertion does
+  class merge_iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const Key&;
+    using pointer = const Key*;
+
+    merge_iterator(const Key* pos, const Key* last, const operation* op,
+      const operation* op_last, const Compare& comp) : pos_(pos),
+      last_(last), op_(op), op_last_(op_last), comp_(&comp)
+    {
+      settle();
+    }
+
+    reference operator*() const
+    {
+      return from_old_ ? *pos_ : op_->first;
+    }
+
+    merge_iterator& operator++()
+    {
+      if(from_old_)
+      {
+        ++pos_;
+      }
+      else
+      {
+        ++op_;
+      }
+      settle();
+      return *this;
+    }
+
+  private:
+    const Key* pos_;
+    const Key* last_;
+    const operation* op_;
+    const operation* op_last_;
+    const Compare* comp_;
+    bool from_old_;
+
+    //skips the erased elements, and picks the smaller of the next
+    //element and the next insertion
+    void settle()
+    {
+      while(op_ != op_last_ && !op_->second && pos_ != last_ &&
+        !(*comp_)(*pos_, op_->first))
+      {
+        ++pos_;
+        ++op_;
+      }
+      from_old_ = op_ == op_last_ ||
+        (pos_ != last_ && (*comp_)(*pos_, op_->first));
+    }
+  };
+
+  std::atomic<const base_set*> current_;
+  mutable ra::util::grace_period readers_;
+  mutable std::mutex write_mutex_;
+  std::mutex publish_mutex_;
+  std::vector<operation, operation_allocator> pending_;
+
+  //applies the queued operations (publish_mutex_ must be held)
+  void publish_pending()
+  {
+    std::vector<operation, operation_allocator> batch(
+      pending_.get_allocator());
+    {
+      std::lock_guard<std::mutex> lock(write_mutex_);
+      batch.swap(pending_);
+    }
+    if(batch.empty())
+    {
+      return;
+    }
+    const base_set* old = current_.load();
+    Compare comp = old->key_comp();
+    //order the operations by key, keeping only the last one queued
+    //for each key
+    std::stable_sort(batch.begin(), batch.end(),
+      [&](const operation& a, const operation& b) {
+        return comp(a.first, b.first);
+      });
+    auto last = batch.begin();
+    for(auto it = batch.begin(); it != batch.end(); ++it)
+    {
+      if(last != it && comp(last->first, it->first))
+      {
+        ++last;
+      }
+      if(last != it)
+      {
+        *last = std::move(*it);
+      }
+    }
+    batch.erase(last + 1, batch.end());
+
+    //keep only the operations that change the old version, and count
+    //the elements of the new one
+    size_type n = old->size();
+    auto kept = batch.begin();
+    auto pos = old->begin();
+    for(operation& op : batch)
+    {
+      pos = std::lower_bound(pos, old->end(), op.first, comp);
+      bool present = pos != old->end() && !comp(op.first, *pos);
+      if(op.second != present)
+      {
+        n = op.second ? n + 1 : n - 1;
+        if(&*kept != &op)
+        {
+          *kept = std::move(op);
+        }
+        ++kept;
+      }
+    }
+    batch.erase(kept, batch.end());
+
+    //the new version is copied straight from the merge of the two
+    std::unique_ptr<base_set> next(new base_set(
+      typename base_set::ordered_and_unique_range(),
+      merge_iterator(old->begin(), old->end(), batch.data(),
+        batch.data() + batch.size(), comp), n, comp,
+      old->get_allocator()));
+    retire(current_.exchange(next.release()));
+  }
+
+  //waits until no snapshot can refer to old, and frees it
+  //(old must no longer be current)
+  void retire(const base_set* old)
+  {
+    readers_.wait();
+    delete old;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef ra_util_grace_period_hpp
+#define ra_util_grace_period_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+namespace ra::util {
+
+// Tracks the readers of data published through an atomic pointer, so
+// that a writer that has replaced the pointer can wait until no
+// reader can still refer to the old data (read-copy-update).
+// Readers hold one of two counts, each split into stripes on separate
+// cache lines, so that readers on different threads do not write to
+// the same cache line. A writer flips the count that new readers use,
+// and waits for the other one to drain (twice, so that both counts
+// are drained).
+class grace_period {
+public:
+
+  using size_type = std::size_t;
+
+  // The number of stripes of each reader count.
+  static constexpr size_type stripes = 64;
+
+  // The hold of a reader on the data published when it was entered.
+  // Data may be read through the published pointer for as long as
+  // the guard exists.
+  class guard {
+  public:
+
+    guard ( guard && other ) noexcept : count_(other.count_)
+    {
+      other.count_ = nullptr;
+    }
+
+    guard (const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+    guard& operator=(guard&&) = delete;
+
+    ~guard()
+    {
+      if(count_ != nullptr)
+      {
+        count_->fetch_sub(1);
+      }
+    }
+
+  private:
+    friend class grace_period;
+
+    explicit guard (std::atomic<long>* count ) noexcept : count_(count) {}
+
+    std::atomic<long>* count_;
+  };
+
+  grace_period () = default;
+
+  grace_period (const grace_period&) = delete;
+  grace_period& operator=(const grace_period&) = delete;
+
+  // Enters a read-side critical section, which lasts until the guard
+  // is destroyed. This never blocks.
+  guard enter () const noexcept
+  {
+    reader_stripe& stripe = stripes_[stripe_index()];
+    std::atomic<long>* count = &stripe.count[phase_.load() & 1];
+    count->fetch_add(1);
+    return guard(count);
+  }
+
+  // Waits until every guard entered before the call has been
+  // destroyed. A thread that holds a guard must not call wait(),
+  // which would wait for it forever, and calls to wait() must not
+  // overlap.
+  void wait () noexcept
+  {
+    for(int round = 0; round < 2; ++round)
+    {
+      unsigned p = phase_.fetch_add(1) & 1;
+      while(readers(p) != 0)
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+private:
+  struct alignas(64) reader_stripe {
+    std::atomic<long> count[2] = {0, 0};
+  };
+
+  std::atomic<unsigned> phase_{0};
+  mutable reader_stripe stripes_[stripes];
+
+  //returns the stripe used by the calling thread
+  static size_type stripe_index() noexcept
+  {
+    static std::atomic<size_type> next{0};
+    thread_local size_type index =
+      next.fetch_add(1, std::memory_order_relaxed) % stripes;
+    return index;
+  }
+
+  //returns the number of readers holding the count of phase p
+  long readers(unsigned p) const noexcept
+  {
+    long n = 0;
+    for(const reader_stripe& stripe : stripes_)
+    {
+      n += stripe.count[p].load();
+    }
+    return n;
+  }
+};
+
+}
+
+#endif
@@ -5,9 +5,11 @@
 #include <iostream>
 #include <memory>
 #include <iterator>
+#include <utility>
 // NOTE: THE FOLLOWING LINE IS NEW!
 #include <cstddef>
 #include "ra/parent_from_member.hpp"
+#include "ra/stats_policy.hpp"
 
 namespace ra :: intrusive {
   // Per-node list management information class.
@@ -32,7 +34,7 @@ public:
   ~list_hook() = default;
 
   private:
-  template <class T , list_hook T ::* Hook > friend class list;
+  template <class T , list_hook T ::* Hook , class Stats > friend class list;
 
   //make it a friend so we can debug
   template <class T , list_hook T ::* Hook > friend class slist_iter;
@@ -114,14 +116,18 @@ private:
         template <class R , list_hook R ::* HookR> friend class slist_iter;
         
         //to be used for iterator decrements and increments, and access node directly
-        template <class R , list_hook R ::* HookR > friend class list;
+        template <class R , list_hook R ::* HookR , class Stats > friend class list;
         
         list_hook_type node_; // pointer to list node
 };
 
   // Intrusive doubly-linked list (with sentinel node).
-  template <class T , list_hook T ::* Hook >
-  class list {
+  // Every change of length is reported to an object of type Stats
+  // (see ra/stats_policy.hpp) as resized(size, size); the default
+  // ra::util::no_stats ignores it and takes no space.
+  template <class T , list_hook T ::* Hook ,
+    class Stats = ra::util::no_stats >
+  class list : private Stats {
   public:
   // The type of the elements in the list.
   using value_type = T;
@@ -145,11 +151,15 @@ private:
   using const_iterator =  slist_iter<const T, Hook>;
   // An unsigned integral type used to represent sizes.
   using size_type = std::size_t;
+  // The type of the object that collects statistics.
+  using stats_policy_type = Stats;
   // Creates an empty list.
   // Time complexity: Constant.
   list()
   {
-
+    //an empty list is a sentinel linked to itself
+    node_.next_ = &node_;
+    node_.prev_ = &node_;
     size_ = 0;
   } 
   // Erases any elements from the list and then destroys the list.
@@ -164,11 +174,11 @@ private:
   // their relative order.
   // After the move, the source list is empty.
   // Time complexity: Constant.
-  list ( list && other )
+  list ( list && other ) : list()
   {
-    node_ = other.node_;
-    size_ = other.size_;
-    other.clear();
+    //the first and last elements point at the sentinel of other, so
+    //the chain is relinked rather than the sentinel copied
+    splice(end(), other);
   }
   // Move assignment.
   // The elements in the source list (i.e., other) are moved from
@@ -184,9 +194,7 @@ private:
      if(this != &other)
       {
         clear();
-        node_ = other.node_;
-        size_ = other.size_;
-        other.clear();
+        splice(end(), other);
       }
       return * this;
   }
@@ -198,14 +206,12 @@ private:
   // Time complexity: Constant.
   void swap ( list & x )
   {
-    list_hook tmp = node_;
-    size_type tmp_size = size_;
-
-    node_ = x.node_;
-    size_ = x.size_;
-
-    x.node_ = tmp;
-    x.size_ = tmp_size;
+    if(this != &x)
+    {
+      list tmp(std::move(x));
+      x.splice(x.end(), *this);
+      splice(end(), tmp);
+    }
   }
   // Returns the number of elements in the list.
   // Time complexity: Constant.
@@ -213,6 +219,11 @@ private:
   {
     return size_;
   }
+  // Returns the object that collects statistics.
+  const stats_policy_type& get_stats () const noexcept
+  {
+    return *this;
+  }
   // Inserts an element in the list before the element referred to
   // by the iterator pos.
   // An iterator that refers to the inserted element is returned.
@@ -243,6 +254,7 @@ private:
 
     //in both cases, return increment size and retun the inserted element
     ++size_;
+    record_size();
     return --pos;
   }
   // Erases the element in the list at the position specified by the
@@ -262,6 +274,7 @@ private:
     pos.node_->next_->prev_ = pos.node_->prev_;
     pos.node_->prev_->next_ = pos.node_->next_;
     --size_;
+    record_size();
     return ++pos;
   }
   
@@ -288,7 +301,8 @@ private:
       node_.prev_ = &(x.*hook_ptr);
       ++size_;      
     }
-    
+    record_size();
+
   }
   // Erases the last element in the list.
   // Precondition: The list is not empty.
@@ -298,6 +312,7 @@ private:
     node_.prev_->prev_->next_ = &(node_);
     node_.prev_ = node_.prev_->prev_;
     --size_;
+    record_size();
   }
   // Returns a reference to the last element in the list.
   // Precondition: The list is not empty.
@@ -310,7 +325,151 @@ private:
 
   const_reference back () const
   {
-    return back();
+    return *ra::util::parent_from_member<T, list_hook>(node_.prev_, Hook);
+  }
+  // Inserts the element x at the front of the list.
+  // Time complexity: Constant.
+  void push_front ( value_type & x )
+  {
+    insert(begin(), x);
+  }
+  // Erases the first element in the list.
+  // Precondition: The list is not empty.
+  // Time complexity: Constant.
+  void pop_front ()
+  {
+    erase(begin());
+  }
+  // Returns a reference to the first element in the list.
+  // Precondition: The list is not empty.
+  // Time complexity: Constant.
+  reference front ()
+  {
+    return *begin();
+  }
+
+  const_reference front () const
+  {
+    return *ra::util::parent_from_member<T, list_hook>(node_.next_, Hook);
+  }
+  // Moves all the elements of other into *this, before the element
+  // referred to by pos, preserving their order; other is left empty.
+  // No element is copied or moved: the chain of other is relinked
+  // as a whole.
+  // Precondition: The objects *this and other are distinct.
+  // Time complexity: Constant.
+  void splice ( iterator pos , list & other )
+  {
+    if(other.size_ != 0)
+    {
+      transfer(pos.node_, other.node_.next_, &other.node_);
+      size_ += other.size_;
+      other.size_ = 0;
+      record_size();
+      other.record_size();
+    }
+  }
+  // Moves the element referred to by it from other into *this,
+  // before the element referred to by pos. The two lists may be the
+  // same list.
+  // Time complexity: Constant.
+  void splice ( iterator pos , list & other , iterator it )
+  {
+    if(pos == it || pos.node_ == it.node_->next_)
+    {
+      return;
+    }
+    transfer(pos.node_, it.node_, it.node_->next_);
+    if(this != &other)
+    {
+      --other.size_;
+      ++size_;
+      record_size();
+      other.record_size();
+    }
+  }
+  // Moves the n elements in the range [first, last) of other into
+  // *this, before the element referred to by pos, preserving their
+  // order.
+  // Precondition: n is the number of elements in [first, last), and
+  // pos is not in that range.
+  // Time complexity: Constant.
+  void splice ( iterator pos , list & other , iterator first ,
+  iterator last , size_type n )
+  {
+    if(first == last || pos == last)
+    {
+      return;
+    }
+    transfer(pos.node_, first.node_, last.node_);
+    if(this != &other)
+    {
+      other.size_ -= n;
+      size_ += n;
+      record_size();
+      other.record_size();
+    }
+  }
+  // As above, counting the elements in [first, last) when they move
+  // from another list.
+  // Time complexity: Linear in the length of the range if other is
+  // not *this, and constant otherwise.
+  void splice ( iterator pos , list & other , iterator first ,
+  iterator last )
+  {
+    size_type n = 0;
+    if(this != &other)
+    {
+      n = std::distance(first, last);
+    }
+    splice(pos, other, first, last, n);
+  }
+  // Merges the elements of other into *this, which must both be
+  // sorted with respect to comp; other is left empty. The merge is
+  // stable: of two equivalent elements, the one from *this comes
+  // first. No element is copied or moved, and each run of other that
+  // goes before the same element of *this is relinked at once.
+  // Time complexity: Linear in the sum of the sizes.
+  template <class Compare >
+  void merge ( list & other , Compare comp )
+  {
+    if(this == &other || other.size_ == 0)
+    {
+      return;
+    }
+    list_hook* first1 = node_.next_;
+    list_hook* first2 = other.node_.next_;
+    list_hook* last2 = &other.node_;
+    while(first1 != &node_ && first2 != last2)
+    {
+      if(comp(value_of(first2), value_of(first1)))
+      {
+        list_hook* next = first2->next_;
+        while(next != last2 && comp(value_of(next), value_of(first1)))
+        {
+          next = next->next_;
+        }
+        transfer(first1, first2, next);
+        first2 = next;
+      }
+      else
+      {
+        first1 = first1->next_;
+      }
+    }
+    if(first2 != last2)
+    {
+      transfer(&node_, first2, last2);
+    }
+    size_ += other.size_;
+    other.size_ = 0;
+    record_size();
+    other.record_size();
+  }
+  // As above, ordering the elements with operator<.
+  void merge ( list & other )
+  {
+    merge(other, [](const T& a, const T& b) { return a < b; });
   }
   // Erases any elements from the list, yielding an empty list.
   // Time complexity: Either linear or constant.
@@ -320,6 +479,7 @@ private:
     node_.next_ = &node_;
     node_.prev_ = &node_;
     size_= 0;
+    record_size();
   }
   // Returns an iterator referring to the first element in the list
   // if the list is not empty and end() otherwise.
@@ -367,6 +527,30 @@ private:
   private:
     list_hook node_;
     size_type size_;
+
+    static T& value_of(list_hook* node) noexcept
+    {
+      return *ra::util::parent_from_member<T, list_hook>(node, Hook);
+    }
+
+    void record_size() const noexcept
+    {
+      Stats::resized(size_, size_);
+    }
+
+    //unlinks the non-empty chain [first, last) from its list and
+    //links it before pos, which must not be in the chain
+    static void transfer(list_hook* pos, list_hook* first, list_hook* last)
+      noexcept
+    {
+      list_hook* tail = last->prev_;
+      first->prev_->next_ = last;
+      last->prev_ = first->prev_;
+      tail->next_ = pos;
+      first->prev_ = pos->prev_;
+      pos->prev_->next_ = first;
+      pos->prev_ = tail;
+    }
 };
 }
 #endif
@@ -0,0 +1,116 @@
+#ifndef ra_util_parallel_sort_hpp
+#define ra_util_parallel_sort_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace ra::util {
+
+// A type used to request that an operation be spread across
+// several threads.
+// A thread count of zero means one thread per hardware thread.
+struct parallel_policy {
+  unsigned threads = 0;
+};
+
+// The default parallel policy.
+inline constexpr parallel_policy par{};
+
+// Returns the number of threads to use for the policy p.
+inline unsigned thread_count(const parallel_policy& p)
+{
+  unsigned n = p.threads ? p.threads : std::thread::hardware_concurrency();
+  return n ? n : 1;
+}
+
+// Sorts the range [first, last) with respect to comp, using the
+// number of threads requested by the policy p.
+// The range is cut into one chunk per thread, each chunk is sorted
+// on its own thread, and neighbouring chunks are then merged
+// pairwise (again in parallel) until one sorted run is left.
+// Small ranges are simply sorted on the calling thread.
+// If any thread throws, the first exception is rethrown after all
+// threads have been joined, and the order of the range is
+// unspecified.
+template <class RandomIt, class Compare>
+void parallel_sort(const parallel_policy& p, RandomIt first, RandomIt last,
+  Compare comp)
+{
+  constexpr std::ptrdiff_t min_chunk = 1 << 14;
+  std::ptrdiff_t n = last - first;
+  std::ptrdiff_t chunks = std::min<std::ptrdiff_t>(thread_count(p),
+    n / min_chunk);
+  if(chunks < 2)
+  {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  //chunk i is [bounds[i], bounds[i + 1])
+  std::vector<RandomIt> bounds;
+  for(std::ptrdiff_t i = 0; i < chunks; ++i)
+  {
+    bounds.push_back(first + n * i / chunks);
+  }
+  bounds.push_back(last);
+
+  std::vector<std::exception_ptr> errors(chunks);
+  auto run = [&](std::ptrdiff_t jobs, auto job) {
+    std::vector<std::thread> threads;
+    for(std::ptrdiff_t i = 0; i < jobs; ++i)
+    {
+      threads.emplace_back([&, i] {
+        try
+        {
+          job(i);
+        } catch(...)
+        {
+          errors[i] = std::current_exception();
+        }
+      });
+    }
+    for(auto& t : threads)
+    {
+      t.join();
+    }
+    for(auto& e : errors)
+    {
+      if(e)
+      {
+        std::rethrow_exception(e);
+      }
+    }
+  };
+
+  run(chunks, [&](std::ptrdiff_t i) {
+    std::sort(bounds[i], bounds[i + 1], comp);
+  });
+
+  //merge neighbouring runs until only one is left
+  while(bounds.size() > 2)
+  {
+    std::ptrdiff_t runs = bounds.size() - 1;
+    run(runs / 2, [&](std::ptrdiff_t i) {
+      std::inplace_merge(bounds[2 * i], bounds[2 * i + 1],
+        bounds[2 * i + 2], comp);
+    });
+    std::vector<RandomIt> next;
+    for(std::size_t i = 0; i < bounds.size(); i += 2)
+    {
+      next.push_back(bounds[i]);
+    }
+    if(next.back() != last)
+    {
+      next.push_back(last);
+    }
+    bounds.swap(next);
+  }
+}
+
+}
+
+#endif
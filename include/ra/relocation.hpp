@@ -0,0 +1,71 @@
+#ifndef ra_relocation_hpp
+#define ra_relocation_hpp
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+namespace ra::container {
+
+// A type is trivially relocatable if moving an object to a new
+// address and destroying the original has the same effect as
+// copying its bytes (and not destroying the original). The sorted
+// containers then move their elements with memmove instead of one
+// move and one destructor call per element.
+// This holds for every trivially copyable type, and for most types
+// that own memory through a pointer. It does not hold for types
+// that point into themselves, such as the std::string of libstdc++
+// (whose short strings point to a buffer inside the object).
+// A type opts in by specializing this template:
+//   template <> struct ra::container::is_trivially_relocatable<T> :
+//     std::true_type {};
+template <class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <class T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+template <class T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <class T1, class T2>
+struct is_trivially_relocatable<std::pair<T1, T2>> :
+  std::bool_constant<is_trivially_relocatable<T1>::value &&
+  is_trivially_relocatable<T2>::value> {};
+
+template <class T>
+inline constexpr bool is_trivially_relocatable_v =
+  is_trivially_relocatable<T>::value;
+
+namespace detail {
+
+// True if Allocator constructs and destroys objects of type T in
+// place like operator new and the destructor, so that relocating
+// them by copying bytes bypasses nothing.
+template <class Allocator, class T>
+inline constexpr bool plain_construct_v =
+  std::is_same_v<Allocator, std::allocator<T>> ||
+  std::is_same_v<Allocator, std::pmr::polymorphic_allocator<T>>;
+
+// Moves the n objects at first to the (possibly overlapping) storage
+// at out by copying their bytes. The objects at first must not be
+// destroyed afterwards.
+template <class T>
+inline void relocate(T* first, std::size_t n, T* out) noexcept
+{
+  static_assert(is_trivially_relocatable_v<T>);
+  if(n != 0)
+  {
+    std::memmove(static_cast<void*>(out), static_cast<const void*>(first),
+      n * sizeof(T));
+  }
+}
+
+}
+
+}
+
+#endif
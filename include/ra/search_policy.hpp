@@ -0,0 +1,602 @@
+#ifndef ra_search_policy_hpp
+#define ra_search_policy_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <memory>
+#include "ra/simd_search.hpp"
+
+namespace ra::container {
+
+// Search policies for sv_set (its fourth template parameter).
+// A policy finds the lower bound of a key in the sorted elements of
+// the set:
+//   const Key* lower_bound(const Key* first, const Key* last,
+//     const Key& k, const Compare& comp) const;
+// and is told by invalidate() that the elements have changed, so
+// that it can drop anything it has learned about them.
+// A policy may also take a std::size_t& probes after comp, to which
+// it adds the number of keys it examines. sv_set calls that form
+// when it collects statistics, so that they describe the search that
+// actually runs; for a policy without it, sv_set counts the calls
+// to comp instead.
+// The interpolation and learned policies only apply to arithmetic
+// keys ordered by std::less; for other keys they fall back to a
+// binary search.
+// A policy may also have
+//   bool may_contain(const Key* first, const Key* last,
+//     const Key& k) const;
+// which find() and contains() call first: if it returns false, the
+// key is taken to be absent without searching. And it may have
+//   void inserted(const Key& k);
+// which single insertions call instead of invalidate().
+
+// True if keys of type Key ordered by Compare can be located by
+// their value (i.e., Key is arithmetic and Compare is std::less).
+template <class Key, class Compare>
+inline constexpr bool interpolable_v = std::is_arithmetic_v<Key> &&
+  !std::is_same_v<Key, bool> && (std::is_same_v<Compare, std::less<Key>> ||
+  std::is_same_v<Compare, std::less<>>);
+
+namespace detail {
+
+// Returns b - a as a double, for a <= b, without overflow.
+template <class Key>
+inline double key_distance(const Key& a, const Key& b) noexcept
+{
+  if constexpr(std::is_integral_v<Key>)
+  {
+    return double(std::uint64_t(b) - std::uint64_t(a));
+  }
+  else
+  {
+    return double(b) - double(a);
+  }
+}
+
+// Maps an arithmetic key to an unsigned integer of the same order,
+// so that keys of any arithmetic type can be kept in one array.
+template <class Key>
+inline std::uint64_t ordered_bits(const Key& k) noexcept
+{
+  if constexpr(std::is_integral_v<Key> && std::is_unsigned_v<Key>)
+  {
+    return k;
+  }
+  else if constexpr(std::is_integral_v<Key>)
+  {
+    return std::uint64_t(std::int64_t(k)) ^ (std::uint64_t(1) << 63);
+  }
+  else
+  {
+    //-0.0 and 0.0 are equal, so they must map to the same value
+    double d = k == 0 ? 0.0 : double(k);
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (std::uint64_t(1) << 63);
+  }
+}
+
+// A counter that may be bumped from several threads at once, with
+// relaxed atomic operations. Unlike std::atomic, it can be copied (a
+// copy takes the current value), so a policy holding one keeps its
+// implicit copy and move operations.
+class relaxed_counter {
+public:
+  relaxed_counter() noexcept : n_(0) {}
+  relaxed_counter(const relaxed_counter& other) noexcept :
+    n_(other.load()) {}
+  relaxed_counter& operator=(const relaxed_counter& other) noexcept
+  {
+    store(other.load());
+    return *this;
+  }
+
+  void operator++() noexcept { n_.fetch_add(1, std::memory_order_relaxed); }
+  std::uint64_t load() const noexcept
+  {
+    return n_.load(std::memory_order_relaxed);
+  }
+  void store(std::uint64_t n) noexcept
+  {
+    n_.store(n, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<std::uint64_t> n_;
+};
+
+// Wraps a comparison object, counting the calls made through it
+// into probes.
+template <class Compare>
+struct probe_compare {
+  const Compare& comp;
+  std::size_t& probes;
+
+  template <class A, class B>
+  bool operator()(const A& a, const B& b) const
+  {
+    ++probes;
+    return comp(a, b);
+  }
+};
+
+// True if the policy S takes a probe count (see above).
+template <class S, class Key, class Compare, class = void>
+struct has_probe_count : std::false_type {};
+
+template <class S, class Key, class Compare>
+struct has_probe_count<S, Key, Compare, std::void_t<decltype(
+  std::declval<const S&>().lower_bound(std::declval<const Key*>(),
+  std::declval<const Key*>(), std::declval<const Key&>(),
+  std::declval<const Compare&>(), std::declval<std::size_t&>()))>> :
+  std::true_type {};
+
+// Calls the lower_bound() of the policy s, adding its probes to
+// probes: through the policy's own count if it has one, or else by
+// counting the calls to comp.
+template <class S, class Key, class Compare>
+const Key* counted_lower_bound(const S& s, const Key* first,
+  const Key* last, const Key& k, const Compare& comp, std::size_t& probes)
+{
+  if constexpr(has_probe_count<S, Key, Compare>::value)
+  {
+    return s.lower_bound(first, last, k, comp, probes);
+  }
+  else
+  {
+    return s.lower_bound(first, last, k,
+      probe_compare<Compare>{comp, probes});
+  }
+}
+
+// True if the policy S has the optional may_contain() and inserted()
+// members for keys of type Key.
+template <class S, class Key, class = void>
+struct has_may_contain : std::false_type {};
+
+template <class S, class Key>
+struct has_may_contain<S, Key, std::void_t<decltype(
+  std::declval<const S&>().may_contain(std::declval<const Key*>(),
+  std::declval<const Key*>(), std::declval<const Key&>()))>> :
+  std::true_type {};
+
+template <class S, class Key, class = void>
+struct has_inserted : std::false_type {};
+
+template <class S, class Key>
+struct has_inserted<S, Key, std::void_t<decltype(
+  std::declval<S&>().inserted(std::declval<const Key&>()))>> :
+  std::true_type {};
+
+}
+
+// Binary search, which needs about log2(n) probes whatever the
+// distribution of the keys.
+// For uint32_t, uint64_t and double keys ordered by std::less, the
+// search is branchless and ends with a vectorized scan (see
+// ra/simd_search.hpp).
+struct binary_search_policy {
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp) const
+  {
+    std::size_t probes = 0;
+    return lower_bound(first, last, k, comp, probes);
+  }
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp, std::size_t& probes) const
+  {
+    if constexpr(ra::util::simd_searchable_v<Key, Compare>)
+    {
+      return ra::util::simd_lower_bound<Key>(first, last, k, probes);
+    }
+    else
+    {
+      return std::lower_bound(first, last, k,
+        detail::probe_compare<Compare>{comp, probes});
+    }
+  }
+
+  void invalidate() noexcept {}
+};
+
+// Interpolation search: each probe guesses the position of the key
+// from its value, assuming that the keys between the current bounds
+// are evenly spread. For nearly uniform keys this takes about
+// log2(log2(n)) probes. After max_steps guesses, or once the range
+// is down to a few cache lines, the search finishes as a binary
+// search, so skewed keys cost at most max_steps extra probes.
+struct interpolation_search_policy {
+
+  static constexpr int max_steps = 8;
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp) const
+  {
+    std::size_t probes = 0;
+    return lower_bound(first, last, k, comp, probes);
+  }
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp, std::size_t& probes) const
+  {
+    if constexpr(!interpolable_v<Key, Compare>)
+    {
+      return binary_search_policy().lower_bound(first, last, k, comp,
+        probes);
+    }
+    else
+    {
+      constexpr std::ptrdiff_t window = 256 / sizeof(Key);
+      //the lower bound is always in [lo, hi]
+      std::ptrdiff_t lo = 0;
+      std::ptrdiff_t hi = last - first;
+      for(int step = 0; step < max_steps && hi - lo > window; ++step)
+      {
+        ++probes;
+        if(!(first[lo] < k))
+        {
+          return first + lo;
+        }
+        ++probes;
+        if(first[hi - 1] < k)
+        {
+          return first + hi;
+        }
+        //first[lo] < k <= first[hi - 1], so the guess is in
+        //[lo + 1, hi - 1]
+        //(the distances of floating point keys may overflow, and the
+        //offset then be NaN, which is taken as the last position)
+        double fraction = detail::key_distance(first[lo], k) /
+          detail::key_distance(first[lo], first[hi - 1]);
+        double offset = fraction * double(hi - lo - 2);
+        std::ptrdiff_t guess = lo + 1 + (offset < double(hi - lo - 2) ?
+          std::ptrdiff_t(offset) : hi - lo - 2);
+        ++probes;
+        if(first[guess] < k)
+        {
+          lo = guess + 1;
+        }
+        else
+        {
+          hi = guess;
+        }
+      }
+      return binary_search_policy().lower_bound(first + lo, first + hi, k,
+        comp, probes);
+    }
+  }
+
+  void invalidate() noexcept {}
+};
+
+// A learned index: a piecewise linear model of the position of each
+// key, whose predictions are off by at most Epsilon positions.
+// A lookup finds the segment of the key (a binary search over the
+// first keys of the segments, which are kept together in a small
+// array) and then searches only the 2 * Epsilon + 2 positions around
+// the prediction.
+// The model is built on the first lookup after the elements change,
+// in one pass over them (shrinking-cone segmentation). Since this
+// happens inside const lookups, a set using this policy must not be
+// read from several threads at once right after it is modified.
+template <std::size_t Epsilon = 32>
+class learned_search_policy {
+public:
+
+  static constexpr std::size_t epsilon = Epsilon;
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp) const
+  {
+    std::size_t probes = 0;
+    return lower_bound(first, last, k, comp, probes);
+  }
+
+  // The probes include those of the first keys of the segments.
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp, std::size_t& probes) const
+  {
+    if constexpr(!interpolable_v<Key, Compare>)
+    {
+      return binary_search_policy().lower_bound(first, last, k, comp,
+        probes);
+    }
+    else
+    {
+      if(!valid_)
+      {
+        build(first, last);
+      }
+      if(first == last || (++probes, k < *first))
+      {
+        return first;
+      }
+      //the last segment whose first key is not greater than k
+      std::size_t s = std::upper_bound(keys_.begin(), keys_.end(),
+        detail::ordered_bits(k), detail::probe_compare<std::less<>>{
+        std::less<>(), probes}) - keys_.begin() - 1;
+      std::size_t begin = starts_[s];
+      std::size_t end = s + 1 < starts_.size() ? starts_[s + 1] :
+        std::size_t(last - first);
+      double guess = double(begin) + slopes_[s] *
+        detail::key_distance(first[begin], k);
+      std::size_t pos = guess < double(end) ? std::size_t(guess) : end;
+      const Key* lo = first + std::max(begin, pos > Epsilon + 1 ?
+        pos - Epsilon - 1 : 0);
+      const Key* hi = first + std::min(end, pos + Epsilon + 2);
+      const Key* r = binary_search_policy().lower_bound(lo, hi, k, comp,
+        probes);
+      //rounding in the model can only push a key out of its window
+      //by a few positions; check, and search the segment if so
+      detail::probe_compare<Compare> counted{comp, probes};
+      if((r != first + begin && !counted(r[-1], k)) ||
+        (r != first + end && counted(r[0], k)))
+      {
+        r = std::lower_bound(first + begin, first + end, k, counted);
+      }
+      return r;
+    }
+  }
+
+  void invalidate() noexcept
+  {
+    valid_ = false;
+  }
+
+  // Returns the number of segments of the model (zero if it has not
+  // been built since the last change).
+  std::size_t segments() const noexcept
+  {
+    return valid_ ? starts_.size() : 0;
+  }
+
+private:
+  //the first key of each segment (as ordered_bits)
+  mutable std::vector<std::uint64_t> keys_;
+  //the index of the first key of each segment
+  mutable std::vector<std::size_t> starts_;
+  //positions per unit of key of each segment
+  mutable std::vector<double> slopes_;
+  mutable bool valid_ = false;
+
+  template <class Key>
+  void build(const Key* first, const Key* last) const
+  {
+    keys_.clear();
+    starts_.clear();
+    slopes_.clear();
+    std::size_t n = last - first;
+    std::size_t begin = 0;
+    while(begin < n)
+    {
+      //the slopes that keep every key of the segment within Epsilon
+      //positions of the line through its first key
+      double lo = 0;
+      double hi = std::numeric_limits<double>::infinity();
+      std::size_t i = begin + 1;
+      for(; i < n; ++i)
+      {
+        double dx = detail::key_distance(first[begin], first[i]);
+        double dy = double(i - begin);
+        double new_lo = std::max(lo, (dy - double(Epsilon)) / dx);
+        double new_hi = std::min(hi, (dy + double(Epsilon)) / dx);
+        if(new_lo > new_hi)
+        {
+          break;
+        }
+        lo = new_lo;
+        hi = new_hi;
+      }
+      keys_.push_back(detail::ordered_bits(first[begin]));
+      starts_.push_back(begin);
+      slopes_.push_back(hi == std::numeric_limits<double>::infinity() ? 0 :
+        (lo + hi) / 2);
+      begin = i;
+    }
+    valid_ = true;
+  }
+};
+
+// A blocked Bloom filter in front of the search of another policy
+// (Inner), so that most lookups of absent keys are answered from one
+// cache line instead of a search over the whole array.
+// Each key sets about 0.69 * BitsPerKey bits within a single 512-bit
+// block chosen by its hash, for a false positive rate of about 1% at
+// 10 bits per key (and about 0.1% at 16). The keys are hashed with
+// std::hash, so the filter only applies to keys whose equivalence
+// under the comparison of the set is equality (for example, not to
+// case-insensitive strings); lower_bound() never uses it.
+// Single insertions add the key to the filter; any other change
+// drops it, and it is rebuilt from the elements on the next lookup.
+// As for learned_search_policy, this happens inside const lookups,
+// so a set using this policy must not be read from several threads
+// at once right after a modification; once the filter is built,
+// lookups may run concurrently (the counters of lookups and
+// rejections are relaxed atomics).
+template <std::size_t BitsPerKey = 10, class Inner = binary_search_policy>
+class filtered_search_policy {
+public:
+
+  static_assert(BitsPerKey > 0, "the filter needs at least one bit per key");
+
+  static constexpr std::size_t bits_per_key = BitsPerKey;
+
+  // The number of bits set by each key.
+  static constexpr int hashes = BitsPerKey * 69 / 100 > 0 ?
+    int(BitsPerKey * 69 / 100) : 1;
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp) const
+  {
+    return inner_.lower_bound(first, last, k, comp);
+  }
+
+  template <class Key, class Compare>
+  const Key* lower_bound(const Key* first, const Key* last, const Key& k,
+    const Compare& comp, std::size_t& probes) const
+  {
+    return detail::counted_lower_bound(inner_, first, last, k, comp, probes);
+  }
+
+  // Returns false if k is certainly not in [first, last).
+  template <class Key>
+  bool may_contain(const Key* first, const Key* last, const Key& k) const
+  {
+    ++lookups_;
+    if(first == last)
+    {
+      ++rejections_;
+      return false;
+    }
+    if(!valid_)
+    {
+      build(first, last);
+    }
+    if(!test(hash(k)))
+    {
+      ++rejections_;
+      return false;
+    }
+    return true;
+  }
+
+  template <class Key>
+  void inserted(const Key& k)
+  {
+    inner_.invalidate();
+    //past twice the keys it was sized for, the filter is rebuilt
+    //bigger rather than letting its false positive rate climb
+    if(valid_ && ++keys_ <= 2 * blocks_.size() * block_bits / BitsPerKey)
+    {
+      add(hash(k));
+    }
+    else
+    {
+      valid_ = false;
+    }
+  }
+
+  void invalidate() noexcept
+  {
+    inner_.invalidate();
+    valid_ = false;
+  }
+
+  // Returns the number of calls to may_contain(), and how many of
+  // them it answered with false.
+  std::size_t lookups() const noexcept { return lookups_.load(); }
+  std::size_t rejections() const noexcept { return rejections_.load(); }
+
+  void reset_counters() noexcept
+  {
+    lookups_.store(0);
+    rejections_.store(0);
+  }
+
+  // Returns the size of the filter in bytes (zero if it has not been
+  // built since the last change).
+  std::size_t filter_bytes() const noexcept
+  {
+    return valid_ ? blocks_.size() * sizeof(block) : 0;
+  }
+
+  const Inner& inner() const noexcept { return inner_; }
+
+private:
+  static constexpr std::size_t block_bits = 512;
+
+  struct alignas(64) block {
+    std::uint64_t words[block_bits / 64];
+  };
+
+  Inner inner_;
+  mutable std::vector<block> blocks_;
+  mutable std::size_t keys_ = 0;
+  mutable bool valid_ = false;
+  mutable detail::relaxed_counter lookups_;
+  mutable detail::relaxed_counter rejections_;
+
+  template <class Key>
+  static std::uint64_t hash(const Key& k)
+  {
+    //finalizer of MurmurHash3, since std::hash may be the identity
+    std::uint64_t h = std::hash<Key>()(k);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  //the low half of the hash picks the block, and the high half
+  //seeds the bit positions within it, so that keys of one block do
+  //not tend to set the same bits
+  const block& block_of(std::uint64_t h) const noexcept
+  {
+    return blocks_[(h & 0xffffffffULL) * blocks_.size() >> 32];
+  }
+
+  template <class F>
+  static void for_each_bit(std::uint64_t h, F f) noexcept
+  {
+    std::uint64_t g = (h >> 32) | 1;
+    for(int i = 0; i < hashes; ++i)
+    {
+      g *= 0x9e3779b97f4a7c15ULL;
+      f(g >> 55);
+    }
+  }
+
+  bool test(std::uint64_t h) const noexcept
+  {
+    const block& b = block_of(h);
+    bool found = true;
+    for_each_bit(h, [&](std::uint64_t bit) {
+      found &= (b.words[bit / 64] >> (bit % 64)) & 1;
+    });
+    return found;
+  }
+
+  void add(std::uint64_t h) const noexcept
+  {
+    block& b = const_cast<block&>(block_of(h));
+    for_each_bit(h, [&](std::uint64_t bit) {
+      b.words[bit / 64] |= std::uint64_t(1) << (bit % 64);
+    });
+  }
+
+  template <class Key>
+  void build(const Key* first, const Key* last) const
+  {
+    std::size_t n = last - first;
+    blocks_.assign((n * BitsPerKey + block_bits - 1) / block_bits, block{});
+    for(; first != last; ++first)
+    {
+      add(hash(*first));
+    }
+    keys_ = n;
+    valid_ = true;
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,446 @@
+#ifndef segmented_sv_set_hpp
+#define segmented_sv_set_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include "ra/simd_search.hpp"
+
+namespace ra::container {
+
+// The default number of elements per chunk of a segmented_sv_set:
+// about 8 KiB of keys.
+template <class Key>
+inline constexpr std::size_t default_chunk_capacity =
+  sizeof(Key) >= 512 ? 16 : 8192 / sizeof(Key);
+
+// A set of unique elements for very large sets that change often,
+// kept as a sequence of sorted chunks of at most ChunkCapacity
+// elements each (like the leaves of a B+-tree, without the interior
+// nodes).
+// A small index holds the first key of every chunk, so a lookup is a
+// search of the index followed by a search of one chunk, each over
+// a contiguous array. An insertion moves at most one chunk's worth
+// of elements (a full chunk is first split in two), and the set
+// never reallocates more than one chunk or the index at a time, so
+// there is no reallocation of the whole array and no doubling of the
+// peak memory.
+// An erasure that leaves a chunk less than a quarter full merges it
+// with a neighbour when both fit in half a chunk.
+// The iterators are bidirectional. Any insertion or erasure
+// invalidates all iterators.
+template <class Key , class Compare = std::less<Key>,
+  std::size_t ChunkCapacity = default_chunk_capacity<Key>>
+class segmented_sv_set {
+public:
+
+  static_assert(ChunkCapacity >= 4, "chunks must hold at least 4 elements");
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using size_type = std::size_t;
+
+  // The largest number of elements in a chunk.
+  static constexpr size_type chunk_capacity = ChunkCapacity;
+
+  // A bidirectional iterator over the elements in order.
+  class const_iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Key*;
+    using reference = const Key&;
+
+    const_iterator () noexcept : set_(nullptr), chunk_(0), pos_(0) {}
+
+    reference operator*() const { return set_->chunks_[chunk_][pos_]; }
+    pointer operator->() const { return &**this; }
+
+    const_iterator& operator++()
+    {
+      if(++pos_ == set_->chunks_[chunk_].size())
+      {
+        ++chunk_;
+        pos_ = 0;
+      }
+      return *this;
+    }
+
+    const_iterator& operator--()
+    {
+      if(pos_ == 0)
+      {
+        --chunk_;
+        pos_ = set_->chunks_[chunk_].size();
+      }
+      --pos_;
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      const_iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    const_iterator operator--(int)
+    {
+      const_iterator tmp(*this);
+      --*this;
+      return tmp;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b)
+    {
+      return a.chunk_ == b.chunk_ && a.pos_ == b.pos_;
+    }
+
+    friend bool operator!=(const const_iterator& a, const const_iterator& b)
+    {
+      return !(a == b);
+    }
+
+    // Returns the index of the chunk of the element, and its
+    // position in that chunk.
+    size_type chunk () const noexcept { return chunk_; }
+    size_type position () const noexcept { return pos_; }
+
+  private:
+    friend class segmented_sv_set;
+
+    const_iterator (const segmented_sv_set* set , size_type chunk ,
+      size_type pos ) noexcept : set_(set), chunk_(chunk), pos_(pos) {}
+
+    const segmented_sv_set* set_;
+    size_type chunk_;
+    size_type pos_;
+  };
+
+  using iterator = const_iterator;
+
+  // Creates an empty set.
+  explicit segmented_sv_set (const Compare& comp = Compare()) :
+    comp_(comp), size_(0) {}
+
+  // Creates a set holding the elements of the range [first, last),
+  // which need not be ordered or unique. The elements are sorted
+  // once, and the chunks are filled to three quarters, leaving room
+  // for insertions.
+  template <class InputIterator , class = typename
+    std::iterator_traits<InputIterator>::iterator_category>
+  segmented_sv_set ( InputIterator first , InputIterator last ,
+  const Compare& comp = Compare()) : segmented_sv_set(comp)
+  {
+    std::vector<Key> keys(first, last);
+    std::sort(keys.begin(), keys.end(), comp_);
+    keys.erase(std::unique(keys.begin(), keys.end(),
+      [this](const Key& a, const Key& b) { return !comp_(a, b); }),
+      keys.end());
+    constexpr size_type fill = ChunkCapacity * 3 / 4;
+    for(size_type i = 0; i < keys.size(); i += fill)
+    {
+      size_type n = std::min(fill, keys.size() - i);
+      chunks_.emplace_back();
+      chunks_.back().reserve(ChunkCapacity);
+      chunks_.back().assign(std::make_move_iterator(keys.begin() + i),
+        std::make_move_iterator(keys.begin() + i + n));
+      firsts_.push_back(chunks_.back().front());
+    }
+    size_ = keys.size();
+  }
+
+  // Creates a set holding the elements of il (see above).
+  segmented_sv_set ( std::initializer_list<Key> il ,
+  const Compare& comp = Compare()) :
+    segmented_sv_set(il.begin(), il.end(), comp) {}
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return comp_;
+  }
+
+  const_iterator begin () const noexcept
+  {
+    return const_iterator(this, 0, 0);
+  }
+  const_iterator end () const noexcept
+  {
+    return const_iterator(this, chunks_.size(), 0);
+  }
+
+  // Returns the number of elements in the set.
+  size_type size () const noexcept
+  {
+    return size_;
+  }
+
+  bool empty () const noexcept
+  {
+    return size_ == 0;
+  }
+
+  // Returns the number of chunks.
+  size_type chunk_count () const noexcept
+  {
+    return chunks_.size();
+  }
+
+  // Returns the elements of chunk i, as a sorted contiguous range.
+  const Key* chunk_begin ( size_type i ) const noexcept
+  {
+    return chunks_[i].data();
+  }
+  const Key* chunk_end ( size_type i ) const noexcept
+  {
+    return chunks_[i].data() + chunks_[i].size();
+  }
+
+  // Erases all elements in the set.
+  void clear () noexcept
+  {
+    chunks_.clear();
+    firsts_.clear();
+    size_ = 0;
+  }
+
+  // Inserts the element x in the set, unless the set holds an
+  // equivalent element already.
+  // Returns an iterator referring to the element equivalent to x,
+  // and true if x was inserted.
+  // At most ChunkCapacity / 2 elements are moved, plus one chunk's
+  // worth if the chunk must be split.
+  std::pair<const_iterator, bool> insert (const key_type & x )
+  {
+    if(chunks_.empty())
+    {
+      chunks_.emplace_back();
+      chunks_.back().reserve(ChunkCapacity);
+      chunks_.back().push_back(x);
+      firsts_.push_back(x);
+      ++size_;
+      return std::make_pair(begin(), true);
+    }
+    size_type c = chunk_of(x);
+    size_type pos = search_chunk(c, x);
+    if(pos != chunks_[c].size() && !comp_(x, chunks_[c][pos]))
+    {
+      return std::make_pair(const_iterator(this, c, pos), false);
+    }
+    if(chunks_[c].size() == ChunkCapacity)
+    {
+      split(c);
+      if(pos > chunks_[c].size())
+      {
+        pos -= chunks_[c].size();
+        ++c;
+      }
+    }
+    chunks_[c].insert(chunks_[c].begin() + pos, x);
+    if(pos == 0)
+    {
+      firsts_[c] = x;
+    }
+    ++size_;
+    return std::make_pair(const_iterator(this, c, pos), true);
+  }
+
+  // Inserts the elements in the range [first, last), which need not
+  // be ordered or unique.
+  template <class InputIterator >
+  void insert ( InputIterator first , InputIterator last )
+  {
+    for(; first != last; ++first)
+    {
+      insert(*first);
+    }
+  }
+
+  // Erases the element referenced by pos.
+  // Returns an iterator referring to the element that followed it.
+  const_iterator erase ( const_iterator pos )
+  {
+    size_type c = pos.chunk_;
+    size_type i = pos.pos_;
+    std::vector<Key>& chunk = chunks_[c];
+    chunk.erase(chunk.begin() + i);
+    --size_;
+    if(chunk.empty())
+    {
+      chunks_.erase(chunks_.begin() + c);
+      firsts_.erase(firsts_.begin() + c);
+      return const_iterator(this, c, 0);
+    }
+    if(i == 0)
+    {
+      firsts_[c] = chunk.front();
+    }
+    if(chunk.size() < ChunkCapacity / 4)
+    {
+      //merge with the next chunk, or else with the previous one
+      if(c + 1 < chunks_.size() &&
+        chunk.size() + chunks_[c + 1].size() <= ChunkCapacity / 2)
+      {
+        merge_next(c);
+      }
+      else if(c > 0 &&
+        chunks_[c - 1].size() + chunk.size() <= ChunkCapacity / 2)
+      {
+        i += chunks_[c - 1].size();
+        merge_next(--c);
+      }
+    }
+    if(i == chunks_[c].size())
+    {
+      return const_iterator(this, c + 1, 0);
+    }
+    return const_iterator(this, c, i);
+  }
+
+  // Erases the element with the key k, if any.
+  // Returns the number of elements erased (zero or one).
+  size_type erase (const key_type & k )
+  {
+    const_iterator pos = find(k);
+    if(pos == end())
+    {
+      return 0;
+    }
+    erase(pos);
+    return 1;
+  }
+
+  // Returns an iterator referring to the first element that is not
+  // ordered before k, or end() if there is no such element.
+  const_iterator lower_bound (const key_type & k ) const
+  {
+    if(chunks_.empty())
+    {
+      return end();
+    }
+    size_type c = chunk_of(k);
+    size_type pos = search_chunk(c, k);
+    if(pos == chunks_[c].size())
+    {
+      return const_iterator(this, c + 1, 0);
+    }
+    return const_iterator(this, c, pos);
+  }
+
+  // Returns an iterator referring to the first element that k is
+  // ordered before, or end() if there is no such element.
+  const_iterator upper_bound (const key_type & k ) const
+  {
+    const_iterator pos = lower_bound(k);
+    if(pos != end() && !comp_(k, *pos))
+    {
+      ++pos;
+    }
+    return pos;
+  }
+
+  // Searches the container for an element with the key k.
+  // If an element is found, an iterator referencing the element
+  // is returned; otherwise, end() is returned.
+  const_iterator find (const key_type & k ) const
+  {
+    const_iterator pos = lower_bound(k);
+    return (pos != end() && !comp_(k, *pos)) ? pos : end();
+  }
+
+  // Returns true if the set holds an element equivalent to k.
+  bool contains (const key_type & k ) const
+  {
+    return find(k) != end();
+  }
+
+  // Returns the number of elements equivalent to k (zero or one).
+  size_type count (const key_type & k ) const
+  {
+    return contains(k) ? 1 : 0;
+  }
+
+  void swap ( segmented_sv_set & x ) noexcept
+  {
+    using std::swap;
+    swap(comp_, x.comp_);
+    chunks_.swap(x.chunks_);
+    firsts_.swap(x.firsts_);
+    swap(size_, x.size_);
+  }
+
+private:
+  Compare comp_;
+  //the chunks in order, each sorted and non-empty, with a capacity
+  //of ChunkCapacity
+  std::vector<std::vector<Key>> chunks_;
+  //the first key of each chunk
+  std::vector<Key> firsts_;
+  size_type size_;
+
+  //returns the index of the chunk where k belongs: the last one whose
+  //first key is not after k, or the first one (chunks_ is not empty)
+  size_type chunk_of(const key_type& k) const
+  {
+    size_type c = std::upper_bound(firsts_.begin(), firsts_.end(), k,
+      comp_) - firsts_.begin();
+    return c == 0 ? 0 : c - 1;
+  }
+
+  //returns the position of the lower bound of k in chunk c
+  size_type search_chunk(size_type c, const key_type& k) const
+  {
+    const Key* first = chunks_[c].data();
+    const Key* last = first + chunks_[c].size();
+    if constexpr(ra::util::simd_searchable_v<Key, Compare>)
+    {
+      return ra::util::simd_lower_bound<Key>(first, last, k) - first;
+    }
+    else
+    {
+      return std::lower_bound(first, last, k, comp_) - first;
+    }
+  }
+
+  //moves the upper half of the full chunk c to a new chunk after it
+  void split(size_type c)
+  {
+    std::vector<Key> upper;
+    upper.reserve(ChunkCapacity);
+    auto middle = chunks_[c].begin() + ChunkCapacity / 2;
+    upper.assign(std::make_move_iterator(middle),
+      std::make_move_iterator(chunks_[c].end()));
+    firsts_.insert(firsts_.begin() + c + 1, upper.front());
+    try
+    {
+      chunks_.insert(chunks_.begin() + c + 1, std::move(upper));
+    } catch(...)
+    {
+      firsts_.erase(firsts_.begin() + c + 1);
+      throw;
+    }
+    chunks_[c].erase(chunks_[c].begin() + ChunkCapacity / 2,
+      chunks_[c].end());
+  }
+
+  //appends chunk c + 1 to chunk c, and removes it
+  void merge_next(size_type c)
+  {
+    std::vector<Key>& next = chunks_[c + 1];
+    chunks_[c].insert(chunks_[c].end(), std::make_move_iterator(next.begin()),
+      std::make_move_iterator(next.end()));
+    chunks_.erase(chunks_.begin() + c + 1);
+    firsts_.erase(firsts_.begin() + c + 1);
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,462 @@
+#ifndef sharded_sv_set_hpp
+#define sharded_sv_set_hpp
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "ra/grace_period.hpp"
+#include "ra/sv_set.hpp"
+
+namespace ra::container {
+
+// A set of unique elements for concurrent writers, partitioned by
+// key range into Shards sv_sets, each with its own lock.
+// Shard i holds the keys from splitter i - 1 (inclusive) up to
+// splitter i (exclusive), so inserts into different shards run in
+// parallel and each shifts only the elements of one shard.
+// Until there are enough elements to choose splitters, every key
+// goes to the first shard. When a shard grows to twice its share of
+// the elements as of the last rebalance, the splitters are chosen
+// again so that the shards are of equal size.
+// The splitters are immutable once published through an atomic
+// pointer, and are freed after a ra::util::grace_period, so finding
+// the shard of a key takes no lock and writes to no shared cache line.
+// An operation then locks only its shard, and retries if a rebalance
+// has published new splitters meanwhile (a rebalance holds the locks
+// of all the shards).
+// Every member function may be called concurrently, except that
+// iterators must not be used while the set is being modified.
+template <class Key , class Compare = std::less<Key>,
+  std::size_t Shards = 16>
+class sharded_sv_set {
+public:
+
+  static_assert(Shards > 0, "there must be at least one shard");
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using size_type = std::size_t;
+
+  // The type of a shard.
+  using shard_set = sv_set<Key, Compare>;
+
+  // The number of shards.
+  static constexpr size_type shard_count = Shards;
+
+  // The smallest shard size that can trigger a rebalance.
+  static constexpr size_type min_rebalance_size = 1024;
+
+  // A forward iterator that visits the elements of every shard in
+  // order.
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Key*;
+    using reference = const Key&;
+
+    const_iterator () noexcept : set_(nullptr), shard_(0), pos_(nullptr) {}
+
+    reference operator*() const { return *pos_; }
+    pointer operator->() const { return pos_; }
+
+    const_iterator& operator++()
+    {
+      ++pos_;
+      skip_empty();
+      return *this;
+    }
+
+    const_iterator operator++(int)
+    {
+      const_iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b)
+    {
+      return a.pos_ == b.pos_;
+    }
+
+    friend bool operator!=(const const_iterator& a, const const_iterator& b)
+    {
+      return a.pos_ != b.pos_;
+    }
+
+  private:
+    friend class sharded_sv_set;
+
+    const_iterator (const sharded_sv_set* set , size_type shard ,
+      const Key* pos ) noexcept : set_(set), shard_(shard), pos_(pos)
+    {
+      skip_empty();
+    }
+
+    //moves past the end of any shard but the last
+    void skip_empty()
+    {
+      while(shard_ + 1 < Shards && pos_ == set_->shards_[shard_].set.end())
+      {
+        ++shard_;
+        pos_ = set_->shards_[shard_].set.begin();
+      }
+    }
+
+    const sharded_sv_set* set_;
+    size_type shard_;
+    const Key* pos_;
+  };
+
+  using iterator = const_iterator;
+
+  // Creates an empty set.
+  explicit sharded_sv_set (const Compare& comp = Compare()) : comp_(comp),
+    splitters_(new splitter_array()), version_(0),
+    limit_(min_rebalance_size)
+  {
+    for(shard& s : shards_)
+    {
+      s.set = shard_set(comp);
+    }
+  }
+
+  // Do not allow the copying or moving of sets.
+  sharded_sv_set (const sharded_sv_set&) = delete;
+  sharded_sv_set& operator=(const sharded_sv_set&) = delete;
+
+  ~sharded_sv_set()
+  {
+    delete splitters_.load();
+  }
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return comp_;
+  }
+
+  // Returns the number of elements in the set.
+  size_type size () const
+  {
+    auto locks = lock_all();
+    size_type n = 0;
+    for(const shard& s : shards_)
+    {
+      n += s.set.size();
+    }
+    return n;
+  }
+
+  bool empty () const
+  {
+    return size() == 0;
+  }
+
+  // Returns the number of elements in shard i.
+  size_type shard_size ( size_type i ) const
+  {
+    std::lock_guard<std::mutex> shard_lock(shards_[i].mutex);
+    return shards_[i].set.size();
+  }
+
+  // Inserts the element x in the set.
+  // Returns true if x was inserted and false if it was already in
+  // the set.
+  bool insert (const key_type & x )
+  {
+    bool inserted;
+    bool skewed;
+    {
+      size_type i;
+      auto shard_lock = lock_shard_of(x, i);
+      shard& s = shards_[i];
+      inserted = s.set.insert(x).second;
+      skewed = s.set.size() > limit_.load(std::memory_order_relaxed);
+    }
+    if(skewed)
+    {
+      rebalance_if_skewed();
+    }
+    return inserted;
+  }
+
+  // Inserts the elements in the range [first, last), which need not
+  // be ordered or unique. The keys are grouped by shard first, so
+  // each shard is locked once and receives a single range insert
+  // (unless a rebalance intervenes, after which the keys not yet
+  // inserted are grouped again).
+  template <class InputIterator >
+  void insert ( InputIterator first , InputIterator last )
+  {
+    bool skewed = false;
+    std::array<std::vector<Key>, Shards> groups;
+    size_type version = group(first, last, groups);
+    for(size_type i = 0; i < Shards; )
+    {
+      if(groups[i].empty())
+      {
+        ++i;
+        continue;
+      }
+      std::unique_lock<std::mutex> shard_lock(shards_[i].mutex);
+      if(version_.load() != version)
+      {
+        //a rebalance has moved the splitters
+        shard_lock.unlock();
+        std::vector<Key> rest;
+        for(size_type j = i; j < Shards; ++j)
+        {
+          rest.insert(rest.end(), std::make_move_iterator(groups[j].begin()),
+            std::make_move_iterator(groups[j].end()));
+          groups[j].clear();
+        }
+        version = group(std::make_move_iterator(rest.begin()),
+          std::make_move_iterator(rest.end()), groups);
+        i = 0;
+        continue;
+      }
+      shards_[i].set.insert(groups[i].begin(), groups[i].end());
+      groups[i].clear();
+      skewed |= shards_[i].set.size() > limit_.load(std::memory_order_relaxed);
+      ++i;
+    }
+    if(skewed)
+    {
+      rebalance_if_skewed();
+    }
+  }
+
+  // Erases the element with the key k, if any.
+  // Returns the number of elements erased (zero or one).
+  size_type erase (const key_type & k )
+  {
+    size_type i;
+    auto shard_lock = lock_shard_of(k, i);
+    shard& s = shards_[i];
+    auto pos = s.set.find(k);
+    if(pos == s.set.end())
+    {
+      return 0;
+    }
+    s.set.erase(pos);
+    return 1;
+  }
+
+  // Returns true if the set holds an element with the key k.
+  bool contains (const key_type & k ) const
+  {
+    size_type i;
+    auto shard_lock = lock_shard_of(k, i);
+    return shards_[i].set.contains(k);
+  }
+
+  // Erases any elements in the container. The splitters are kept.
+  void clear ()
+  {
+    auto locks = lock_all();
+    for(shard& s : shards_)
+    {
+      s.set.clear();
+    }
+  }
+
+  // Returns iterators over all the elements in sorted order.
+  // The set must not be modified while they are in use.
+  const_iterator begin () const
+  {
+    return const_iterator(this, 0, shards_[0].set.begin());
+  }
+  const_iterator end () const
+  {
+    return const_iterator(this, Shards - 1, shards_[Shards - 1].set.end());
+  }
+
+  // Chooses the splitters again so that all shards hold the same
+  // number of elements (give or take one), and moves the elements to
+  // their new shards. This blocks all other operations, and takes
+  // time linear in the size of the set.
+  // Does nothing if there are fewer elements than shards.
+  void rebalance ()
+  {
+    std::lock_guard<std::mutex> lock(rebalance_mutex_);
+    const splitter_array* old;
+    {
+      auto locks = lock_all();
+      old = rebalance_locked();
+    }
+    retire(old);
+  }
+
+private:
+  struct alignas(64) shard {
+    mutable std::mutex mutex;
+    shard_set set;
+  };
+
+  //the splitters as published; inactive until the first rebalance
+  struct splitter_array {
+    std::array<Key, Shards - 1> keys;
+    bool active = false;
+  };
+
+  using shard_locks = std::array<std::unique_lock<std::mutex>, Shards>;
+
+  Compare comp_;
+  std::array<shard, Shards> shards_;
+  //replaced only while all the shards are locked
+  std::atomic<const splitter_array*> splitters_;
+  //counts the splitters published; changes only while all the shards
+  //are locked, so an operation that holds the lock of its shard and
+  //sees the version it chose the shard by may use the shard
+  std::atomic<size_type> version_;
+  mutable ra::util::grace_period readers_;
+  //serializes rebalances, and so the waits for grace periods
+  std::mutex rebalance_mutex_;
+  //a shard larger than this triggers a rebalance
+  std::atomic<size_type> limit_;
+
+  //returns the index of the shard for k under the splitters s
+  size_type shard_of(const splitter_array& s, const key_type& k) const
+  {
+    if(!s.active)
+    {
+      return 0;
+    }
+    return std::upper_bound(s.keys.begin(), s.keys.end(), k, comp_) -
+      s.keys.begin();
+  }
+
+  //locks the shard that holds k, and stores its index in i
+  std::unique_lock<std::mutex> lock_shard_of(const key_type& k,
+    size_type& i) const
+  {
+    for(;;)
+    {
+      size_type version;
+      {
+        auto guard = readers_.enter();
+        version = version_.load();
+        i = shard_of(*splitters_.load(), k);
+      }
+      std::unique_lock<std::mutex> lock(shards_[i].mutex);
+      if(version_.load() == version)
+      {
+        return lock;
+      }
+    }
+  }
+
+  //adds the keys in [first, last) to the groups of their shards, and
+  //returns the version of the splitters used
+  template <class InputIterator >
+  size_type group(InputIterator first, InputIterator last,
+    std::array<std::vector<Key>, Shards>& groups) const
+  {
+    auto guard = readers_.enter();
+    size_type version = version_.load();
+    const splitter_array& splitters = *splitters_.load();
+    for(; first != last; ++first)
+    {
+      auto&& k = *first;
+      groups[shard_of(splitters, k)].push_back(std::forward<decltype(k)>(k));
+    }
+    return version;
+  }
+
+  //locks every shard, in order
+  shard_locks lock_all() const
+  {
+    shard_locks locks;
+    for(size_type i = 0; i < Shards; ++i)
+    {
+      locks[i] = std::unique_lock<std::mutex>(shards_[i].mutex);
+    }
+    return locks;
+  }
+
+  //frees splitters that are no longer published, once no operation
+  //can still be reading them (the rebalance mutex must be held)
+  void retire(const splitter_array* old)
+  {
+    if(old != nullptr)
+    {
+      readers_.wait();
+      delete old;
+    }
+  }
+
+  void rebalance_if_skewed()
+  {
+    std::lock_guard<std::mutex> lock(rebalance_mutex_);
+    const splitter_array* old = nullptr;
+    {
+      auto locks = lock_all();
+      //another thread may have rebalanced already
+      for(const shard& s : shards_)
+      {
+        if(s.set.size() > limit_.load(std::memory_order_relaxed))
+        {
+          old = rebalance_locked();
+          break;
+        }
+      }
+    }
+    retire(old);
+  }
+
+  //rebalances the shards (whose locks must be held), and returns the
+  //splitters it replaced, or nullptr if it kept them
+  const splitter_array* rebalance_locked()
+  {
+    size_type n = 0;
+    for(const shard& s : shards_)
+    {
+      n += s.set.size();
+    }
+    if(n < Shards)
+    {
+      return nullptr;
+    }
+    std::unique_ptr<splitter_array> splitters(new splitter_array());
+    //the shards are in key order, so their concatenation is sorted
+    std::vector<Key> all;
+    all.reserve(n);
+    for(shard& s : shards_)
+    {
+      all.insert(all.end(), std::make_move_iterator(s.set.begin()),
+        std::make_move_iterator(s.set.end()));
+      s.set.clear();
+    }
+    for(size_type i = 0; i < Shards; ++i)
+    {
+      size_type lo = i * n / Shards;
+      size_type hi = (i + 1) * n / Shards;
+      if(i > 0)
+      {
+        splitters->keys[i - 1] = all[lo];
+      }
+      shards_[i].set = shard_set(
+        typename shard_set::ordered_and_unique_range(),
+        std::make_move_iterator(all.begin() + lo), hi - lo, comp_);
+    }
+    splitters->active = true;
+    limit_.store(std::max(min_rebalance_size, 2 * n / Shards),
+      std::memory_order_relaxed);
+    const splitter_array* old = splitters_.exchange(splitters.release());
+    version_.fetch_add(1);
+    return old;
+  }
+};
+
+}
+
+#endif
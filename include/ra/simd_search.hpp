@@ -0,0 +1,293 @@
+#ifndef ra_util_simd_search_hpp
+#define ra_util_simd_search_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RA_SIMD_SEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ra::util {
+
+// True if keys of type Key ordered by Compare can be searched with
+// simd_lower_bound (i.e., Key is uint32_t, uint64_t or double and
+// Compare is std::less).
+template <class Key, class Compare>
+inline constexpr bool simd_searchable_v =
+  (std::is_same_v<Key, std::uint32_t> || std::is_same_v<Key, std::uint64_t>
+  || std::is_same_v<Key, double>) &&
+  (std::is_same_v<Compare, std::less<Key>> ||
+  std::is_same_v<Compare, std::less<>>);
+
+namespace simd_detail {
+
+// Returns the number of elements of [p, p + n) that are less than
+// key. This is also the offset of the lower bound of key if the
+// range is sorted.
+template <class T>
+inline std::size_t count_less_scalar(const T* p, std::size_t n, T key)
+{
+  std::size_t count = 0;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    count += p[i] < key;
+  }
+  return count;
+}
+
+#ifdef RA_SIMD_SEARCH_X86
+
+// The unsigned kernels flip the sign bit so that the signed
+// compare instructions give the unsigned order.
+
+__attribute__((target("avx2")))
+inline std::size_t count_less_avx2(const std::uint32_t* p, std::size_t n,
+  std::uint32_t key)
+{
+  const __m256i bias = _mm256_set1_epi32(INT32_MIN);
+  const __m256i k = _mm256_xor_si256(_mm256_set1_epi32(key), bias);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for(; i + 8 <= n; i += 8)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    __m256i lt = _mm256_cmpgt_epi32(k, _mm256_xor_si256(v, bias));
+    count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(lt)));
+  }
+  return count + count_less_scalar(p + i, n - i, key);
+}
+
+__attribute__((target("avx2")))
+inline std::size_t count_less_avx2(const std::uint64_t* p, std::size_t n,
+  std::uint64_t key)
+{
+  const __m256i bias = _mm256_set1_epi64x(INT64_MIN);
+  const __m256i k = _mm256_xor_si256(
+    _mm256_set1_epi64x(static_cast<long long>(key)), bias);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for(; i + 4 <= n; i += 4)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    __m256i lt = _mm256_cmpgt_epi64(k, _mm256_xor_si256(v, bias));
+    count += __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(lt)));
+  }
+  return count + count_less_scalar(p + i, n - i, key);
+}
+
+__attribute__((target("avx2")))
+inline std::size_t count_less_avx2(const double* p, std::size_t n,
+  double key)
+{
+  const __m256d k = _mm256_set1_pd(key);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for(; i + 4 <= n; i += 4)
+  {
+    __m256d lt = _mm256_cmp_pd(_mm256_loadu_pd(p + i), k, _CMP_LT_OQ);
+    count += __builtin_popcount(_mm256_movemask_pd(lt));
+  }
+  return count + count_less_scalar(p + i, n - i, key);
+}
+
+__attribute__((target("sse4.2")))
+inline std::size_t count_less_sse4(const std::uint32_t* p, std::size_t n,
+  std::uint32_t key)
+{
+  const __m128i bias = _mm_set1_epi32(INT32_MIN);
+  const __m128i k = _mm_xor_si128(_mm_set1_epi32(key), bias);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for(; i + 4 <= n; i += 4)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    __m128i lt = _mm_cmpgt_epi32(k, _mm_xor_si128(v, bias));
+    count += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(lt)));
+  }
+  return count + count_less_scalar(p + i, n - i, key);
+}
+
+__attribute__((target("sse4.2")))
+inline std::size_t count_less_sse4(const std::uint64_t* p, std::size_t n,
+  std::uint64_t key)
+{
+  const __m128i bias = _mm_set1_epi64x(INT64_MIN);
+  const __m128i k = _mm_xor_si128(
+    _mm_set1_epi64x(static_cast<long long>(key)), bias);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for(; i + 2 <= n; i += 2)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    __m128i lt = _mm_cmpgt_epi64(k, _mm_xor_si128(v, bias));
+    count += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(lt)));
+  }
+  return count + count_less_scalar(p + i, n - i, key);
+}
+
+__attribute__((target("sse4.2")))
+inline std::size_t count_less_sse4(const double* p, std::size_t n,
+  double key)
+{
+  const __m128d k = _mm_set1_pd(key);
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for(; i + 2 <= n; i += 2)
+  {
+    __m128d lt = _mm_cmplt_pd(_mm_loadu_pd(p + i), k);
+    count += __builtin_popcount(_mm_movemask_pd(lt));
+  }
+  return count + count_less_scalar(p + i, n - i, key);
+}
+
+#endif
+
+// The instruction sets that the kernels can use.
+enum class isa { scalar, sse4, avx2 };
+
+// Returns the best instruction set supported by this CPU.
+// The answer is computed once.
+inline isa detected_isa()
+{
+#ifdef RA_SIMD_SEARCH_X86
+  static const isa best = [] {
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2"))
+    {
+      return isa::avx2;
+    }
+    if(__builtin_cpu_supports("sse4.2"))
+    {
+      return isa::sse4;
+    }
+    return isa::scalar;
+  }();
+  return best;
+#else
+  return isa::scalar;
+#endif
+}
+
+template <class T>
+inline std::size_t count_less(const T* p, std::size_t n, T key)
+{
+#ifdef RA_SIMD_SEARCH_X86
+  switch(detected_isa())
+  {
+  case isa::avx2:
+    return count_less_avx2(p, n, key);
+  case isa::sse4:
+    return count_less_sse4(p, n, key);
+  default:
+    break;
+  }
+#endif
+  return count_less_scalar(p, n, key);
+}
+
+}
+
+// True if sorted ranges of Key ordered by Compare can be intersected
+// with simd_intersect (i.e., Key is uint32_t and Compare is
+// std::less).
+template <class Key, class Compare>
+inline constexpr bool simd_intersectable_v =
+  std::is_same_v<Key, std::uint32_t> && simd_searchable_v<Key, Compare>;
+
+// Writes to out the elements that are in both of the sorted and
+// unique ranges [a, a + na) and [b, b + nb), in ascending order, and
+// returns the number written.
+// Blocks of four elements from each range are compared all against
+// all with SSE2 (which every x86-64 CPU has), and the block with the
+// smaller last element is then advanced.
+inline std::size_t simd_intersect(const std::uint32_t* a, std::size_t na,
+  const std::uint32_t* b, std::size_t nb, std::uint32_t* out)
+{
+  std::size_t i = 0;
+  std::size_t j = 0;
+  std::size_t k = 0;
+#if defined(RA_SIMD_SEARCH_X86) && defined(__SSE2__)
+  while(i + 4 <= na && j + 4 <= nb)
+  {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+    __m128i eq = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi32(va, vb),
+        _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)))),
+      _mm_or_si128(
+        _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2))),
+        _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)))));
+    int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+    for(int bit = 0; bit < 4; ++bit)
+    {
+      if(mask & (1 << bit))
+      {
+        out[k++] = a[i + bit];
+      }
+    }
+    std::uint32_t amax = a[i + 3];
+    std::uint32_t bmax = b[j + 3];
+    i += amax <= bmax ? 4 : 0;
+    j += bmax <= amax ? 4 : 0;
+  }
+#endif
+  while(i < na && j < nb)
+  {
+    if(a[i] < b[j])
+    {
+      ++i;
+    }
+    else if(b[j] < a[i])
+    {
+      ++j;
+    }
+    else
+    {
+      out[k++] = a[i];
+      ++i;
+      ++j;
+    }
+  }
+  return k;
+}
+
+// Returns the first position in the sorted range [first, last)
+// whose element is not less than key (as std::lower_bound would),
+// and adds to probes the number of elements compared with key.
+// The range is narrowed with a branchless binary search until it
+// spans a few cache lines, which are then scanned with the widest
+// vector instructions the CPU supports (chosen at run time); the
+// scan compares every element of those lines.
+template <class T>
+inline const T* simd_lower_bound(const T* first, const T* last, T key,
+  std::size_t& probes)
+{
+  //four cache lines
+  constexpr std::size_t window = 256 / sizeof(T);
+  std::size_t n = last - first;
+  while(n > window)
+  {
+    std::size_t half = n / 2;
+    first = (first[half - 1] < key) ? first + half : first;
+    n -= half;
+    ++probes;
+  }
+  probes += n;
+  return first + simd_detail::count_less(first, n, key);
+}
+
+// As above, without counting the probes.
+template <class T>
+inline const T* simd_lower_bound(const T* first, const T* last, T key)
+{
+  std::size_t probes = 0;
+  return simd_lower_bound(first, last, key, probes);
+}
+
+}
+
+#endif
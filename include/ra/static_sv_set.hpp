@@ -0,0 +1,241 @@
+#ifndef static_sv_set_hpp
+#define static_sv_set_hpp
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace ra::container {
+
+// A set of exactly N unique elements fixed when it is constructed,
+// for lookup tables (keywords, opcodes) known at compile time.
+// The constructor is constexpr: it sorts the keys and checks that
+// they are unique, so a constexpr set is built entirely by the
+// compiler and placed in read-only data, with no work and no heap
+// memory at startup. Repeated keys make the constructor throw
+// std::invalid_argument, which is a compile error in a constant
+// expression.
+// A lookup is a branchless binary search unrolled at compile time
+// into its ceil(log2(N)) steps, each a compare whose result is added
+// to the position, so arithmetic keys compile to straight-line code.
+// Lookups are constexpr too.
+// Key must be a literal type, and Compare's operator() must be
+// constexpr (as for std::less).
+template <class Key , std::size_t N , class Compare = std::less<Key>>
+class static_sv_set {
+public:
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using size_type = std::size_t;
+
+  // The (random-access) iterator type; the elements can only be
+  // read.
+  using iterator = const Key *;
+  using const_iterator = const Key *;
+
+  // Creates a set holding the N keys, which must be unique but may
+  // be in any order.
+  // Throws std::invalid_argument if two keys are equivalent.
+  // (Only for N > 0, since there are no arrays of size zero; an empty
+  // set is made from a std::array.)
+  template <std::size_t M = N ,
+    class = std::enable_if_t<M == N && M != 0>>
+  constexpr explicit static_sv_set (const Key (&keys)[M] ,
+  const Compare& comp = Compare()) : static_sv_set(keys, comp,
+    std::make_index_sequence<N>()) {}
+
+  // As above, for keys in a std::array.
+  constexpr explicit static_sv_set (const std::array<Key, N>& keys ,
+  const Compare& comp = Compare()) : static_sv_set(keys, comp,
+    std::make_index_sequence<N>()) {}
+
+  // Returns the comparison object for the container.
+  constexpr key_compare key_comp () const
+  {
+    return comp_;
+  }
+
+  constexpr const_iterator begin () const noexcept { return keys_.data(); }
+  constexpr const_iterator end () const noexcept
+  {
+    return keys_.data() + N;
+  }
+
+  static constexpr size_type size () noexcept { return N; }
+  static constexpr bool empty () noexcept { return N == 0; }
+
+  // Returns a pointer to the sorted array of keys.
+  constexpr const Key* data () const noexcept { return keys_.data(); }
+
+  // Returns an iterator referring to the first element that is not
+  // ordered before k, or end() if there is no such element.
+  constexpr const_iterator lower_bound (const key_type & k ) const
+  {
+    return lower_bound_of(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  constexpr const_iterator lower_bound (const K & k ) const
+  {
+    return lower_bound_of(k);
+  }
+
+  // Returns an iterator referring to the first element that k is
+  // ordered before, or end() if there is no such element.
+  constexpr const_iterator upper_bound (const key_type & k ) const
+  {
+    return upper_bound_of(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  constexpr const_iterator upper_bound (const K & k ) const
+  {
+    return upper_bound_of(k);
+  }
+
+  // Searches the container for an element with the key k.
+  // If an element is found, an iterator referencing the element
+  // is returned; otherwise, end() is returned.
+  constexpr const_iterator find (const key_type & k ) const
+  {
+    return find_impl(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  constexpr const_iterator find (const K & k ) const
+  {
+    return find_impl(k);
+  }
+
+  // Returns true if the set holds an element equivalent to k.
+  constexpr bool contains (const key_type & k ) const
+  {
+    return find_impl(k) != end();
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  constexpr bool contains (const K & k ) const
+  {
+    return find_impl(k) != end();
+  }
+
+  // Returns the number of elements equivalent to k (zero or one).
+  constexpr size_type count (const key_type & k ) const
+  {
+    return contains(k) ? 1 : 0;
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  constexpr size_type count (const K & k ) const
+  {
+    return contains(k) ? 1 : 0;
+  }
+
+  // Returns the position of the element equivalent to k in the
+  // sorted order, or size() if there is none (for example, to index
+  // a parallel table of values).
+  template <class K >
+  constexpr size_type index_of (const K & k ) const
+  {
+    return find_impl(k) - begin();
+  }
+
+private:
+  Compare comp_;
+  std::array<Key, N> keys_;
+
+  template <class Keys, std::size_t... I>
+  constexpr static_sv_set(const Keys& keys, const Compare& comp,
+    std::index_sequence<I...>) : comp_(comp), keys_{{keys[I]...}}
+  {
+    //insertion sort, which a constant expression can run (std::sort
+    //is not constexpr before C++20)
+    for(size_type i = 1; i < N; ++i)
+    {
+      for(size_type j = i; j > 0 && comp_(keys_[j], keys_[j - 1]); --j)
+      {
+        Key tmp = keys_[j];
+        keys_[j] = keys_[j - 1];
+        keys_[j - 1] = tmp;
+      }
+    }
+    for(size_type i = 1; i < N; ++i)
+    {
+      if(!comp_(keys_[i - 1], keys_[i]))
+      {
+        throw std::invalid_argument("static_sv_set: repeated key");
+      }
+    }
+  }
+
+  //branchless: the steps are generated at compile time from N (one
+  //instantiation per step), and each one is a compare whose result
+  //is added to the base rather than branched on
+  template <size_type M, class K>
+  constexpr const Key* search_steps(const Key* base, const K& k) const
+  {
+    if constexpr(M <= 1)
+    {
+      return base;
+    }
+    else
+    {
+      constexpr size_type half = M / 2;
+      base += half * size_type(comp_(base[half - 1], k));
+      return search_steps<M - half>(base, k);
+    }
+  }
+
+  template <class K>
+  constexpr const_iterator lower_bound_of(const K& k) const
+  {
+    if constexpr(N == 0)
+    {
+      return begin();
+    }
+    else
+    {
+      const Key* base = search_steps<N>(keys_.data(), k);
+      return base + size_type(comp_(*base, k));
+    }
+  }
+
+  template <class K>
+  constexpr const_iterator upper_bound_of(const K& k) const
+  {
+    const_iterator pos = lower_bound_of(k);
+    return (pos != end() && !comp_(k, *pos)) ? pos + 1 : pos;
+  }
+
+  template <class K>
+  constexpr const_iterator find_impl(const K& k) const
+  {
+    const_iterator pos = lower_bound_of(k);
+    return (pos != end() && !comp_(k, *pos)) ? pos : end();
+  }
+};
+
+// Returns a static_sv_set holding the keys, deducing N from their
+// number, e.g.
+//   constexpr auto ops = make_static_sv_set<std::string_view>(
+//     {"add", "sub", "mul"});
+template <class Key , class Compare = std::less<Key>, std::size_t N >
+constexpr static_sv_set<Key, N, Compare> make_static_sv_set (
+const Key (&keys)[N] , const Compare& comp = Compare())
+{
+  return static_sv_set<Key, N, Compare>(keys, comp);
+}
+
+}
+
+#endif
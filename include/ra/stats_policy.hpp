@@ -0,0 +1,267 @@
+#ifndef ra_stats_policy_hpp
+#define ra_stats_policy_hpp
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+
+namespace ra::util {
+
+// Statistics policies for sv_set (its sixth template parameter) and
+// ra::intrusive::list (its third).
+// A container reports what it does to its policy through
+//   void searched(std::size_t comparisons) const;
+//   void moved(std::size_t elements, std::size_t bytes) const;
+//   void reallocated(std::size_t old_capacity,
+//     std::size_t new_capacity) const;
+//   void resized(std::size_t size, std::size_t capacity) const;
+// which are const since lookups are, and since lookups may run on
+// several threads at once. If the policy's enabled is true, sv_set
+// also has its search policy count the keys each lookup examines
+// (see ra/search_policy.hpp), which it reports as comparisons; the
+// lookups run the same search as without statistics.
+// The counters belong to the container object: they are not copied,
+// moved or swapped along with its elements.
+
+// The default policy: every call is empty, and the policy is an
+// empty base of the container, so it costs neither time nor space.
+struct no_stats {
+  static constexpr bool enabled = false;
+
+  void searched(std::size_t ) const noexcept {}
+  void moved(std::size_t , std::size_t ) const noexcept {}
+  void reallocated(std::size_t , std::size_t ) const noexcept {}
+  void resized(std::size_t , std::size_t ) const noexcept {}
+};
+
+// The counters of a container_stats at one point in time, for
+// export.
+// The histograms have one bucket per power of two: bucket 0 counts
+// the value 0, and bucket b > 0 the values in [2^(b-1), 2^b), with
+// the last bucket also counting every larger value.
+struct stats_snapshot {
+  static constexpr std::size_t buckets = 24;
+
+  // The number of lookups, and the key comparisons they made.
+  std::uint64_t lookups = 0;
+  std::uint64_t comparisons = 0;
+  // The number of elements moved by shifts and reallocations, and
+  // their size in bytes.
+  std::uint64_t moves = 0;
+  std::uint64_t bytes_moved = 0;
+  // The number of times the storage was reallocated.
+  std::uint64_t reallocations = 0;
+  // The number of changes of size (insertions, erasures, clears).
+  std::uint64_t changes = 0;
+  // The size and capacity after the last change, and the largest
+  // size and capacity seen.
+  std::uint64_t size = 0;
+  std::uint64_t capacity = 0;
+  std::uint64_t peak_size = 0;
+  std::uint64_t peak_capacity = 0;
+  // Lookups by the number of comparisons each made.
+  std::array<std::uint64_t, buckets> comparison_histogram{};
+  // Changes by the size they left.
+  std::array<std::uint64_t, buckets> size_histogram{};
+
+  // Returns the number of elements of storage that are allocated but
+  // unused.
+  std::uint64_t wasted_capacity() const noexcept
+  {
+    return capacity - size;
+  }
+
+  // Returns the average number of comparisons per lookup.
+  double comparisons_per_lookup() const noexcept
+  {
+    return lookups != 0 ? double(comparisons) / lookups : 0.0;
+  }
+
+  // Calls f(name, value) for every counter, with name a const char*
+  // for the scalar counters and a std::string such as
+  // "comparison_histogram_3" for the histogram buckets, so that the
+  // counters can be fed to a metrics system.
+  template <class F>
+  void for_each(F f) const
+  {
+    f("lookups", lookups);
+    f("comparisons", comparisons);
+    f("moves", moves);
+    f("bytes_moved", bytes_moved);
+    f("reallocations", reallocations);
+    f("changes", changes);
+    f("size", size);
+    f("capacity", capacity);
+    f("wasted_capacity", wasted_capacity());
+    f("peak_size", peak_size);
+    f("peak_capacity", peak_capacity);
+    for(std::size_t b = 0; b < buckets; ++b)
+    {
+      f("comparison_histogram_" + std::to_string(b),
+        comparison_histogram[b]);
+    }
+    for(std::size_t b = 0; b < buckets; ++b)
+    {
+      f("size_histogram_" + std::to_string(b), size_histogram[b]);
+    }
+  }
+
+  // Returns the histogram bucket of value.
+  static std::size_t bucket(std::size_t value) noexcept
+  {
+    std::size_t b = 0;
+    for(; value != 0 && b < buckets - 1; value >>= 1)
+    {
+      ++b;
+    }
+    return b;
+  }
+};
+
+// Writes every counter of s, one "name value" pair per line, leaving
+// out empty histogram buckets.
+inline std::ostream& operator<<(std::ostream& out , const stats_snapshot& s )
+{
+  s.for_each([&out](const auto& name, std::uint64_t value) {
+    if(value != 0 || std::string(name).find("histogram") == std::string::npos)
+    {
+      out << name << ' ' << value << '\n';
+    }
+  });
+  return out;
+}
+
+// A policy that collects the counters of a stats_snapshot, with
+// relaxed atomic operations, so that lookups on several threads may
+// record at once. A count may be a little behind while other threads
+// are recording, but no count is lost.
+class container_stats {
+public:
+  static constexpr bool enabled = true;
+
+  container_stats() = default;
+
+  // A copy starts with fresh counters (see above).
+  container_stats(const container_stats&) noexcept {}
+  container_stats& operator=(const container_stats&) noexcept
+  {
+    return *this;
+  }
+
+  void searched(std::size_t comparisons ) const noexcept
+  {
+    add(lookups_, 1);
+    add(comparisons_, comparisons);
+    add(comparison_histogram_[stats_snapshot::bucket(comparisons)], 1);
+  }
+
+  void moved(std::size_t elements , std::size_t bytes ) const noexcept
+  {
+    add(moves_, elements);
+    add(bytes_moved_, bytes);
+  }
+
+  void reallocated(std::size_t , std::size_t new_capacity ) const noexcept
+  {
+    add(reallocations_, 1);
+    raise(peak_capacity_, new_capacity);
+  }
+
+  void resized(std::size_t size , std::size_t capacity ) const noexcept
+  {
+    add(changes_, 1);
+    add(size_histogram_[stats_snapshot::bucket(size)], 1);
+    size_.store(size, std::memory_order_relaxed);
+    capacity_.store(capacity, std::memory_order_relaxed);
+    raise(peak_size_, size);
+    raise(peak_capacity_, capacity);
+  }
+
+  // Returns a copy of the counters.
+  stats_snapshot snapshot() const noexcept
+  {
+    stats_snapshot s;
+    s.lookups = load(lookups_);
+    s.comparisons = load(comparisons_);
+    s.moves = load(moves_);
+    s.bytes_moved = load(bytes_moved_);
+    s.reallocations = load(reallocations_);
+    s.changes = load(changes_);
+    s.size = load(size_);
+    s.capacity = load(capacity_);
+    s.peak_size = load(peak_size_);
+    s.peak_capacity = load(peak_capacity_);
+    for(std::size_t b = 0; b < stats_snapshot::buckets; ++b)
+    {
+      s.comparison_histogram[b] = load(comparison_histogram_[b]);
+      s.size_histogram[b] = load(size_histogram_[b]);
+    }
+    return s;
+  }
+
+  // Zeroes the event counters (lookups, comparisons, moves,
+  // reallocations, changes and the histograms), and lowers the peaks
+  // to the current size and capacity. It is const like the
+  // recording calls, so that a scraper holding a const reference can
+  // reset the counters it has exported.
+  void reset() const noexcept
+  {
+    for(counter* c : {&lookups_, &comparisons_, &moves_, &bytes_moved_,
+      &reallocations_, &changes_})
+    {
+      c->store(0, std::memory_order_relaxed);
+    }
+    for(std::size_t b = 0; b < stats_snapshot::buckets; ++b)
+    {
+      comparison_histogram_[b].store(0, std::memory_order_relaxed);
+      size_histogram_[b].store(0, std::memory_order_relaxed);
+    }
+    peak_size_.store(load(size_), std::memory_order_relaxed);
+    peak_capacity_.store(load(capacity_), std::memory_order_relaxed);
+  }
+
+private:
+  using counter = std::atomic<std::uint64_t>;
+
+  mutable counter lookups_{0};
+  mutable counter comparisons_{0};
+  mutable counter moves_{0};
+  mutable counter bytes_moved_{0};
+  mutable counter reallocations_{0};
+  mutable counter changes_{0};
+  mutable counter size_{0};
+  mutable counter capacity_{0};
+  mutable counter peak_size_{0};
+  mutable counter peak_capacity_{0};
+  mutable std::array<counter, stats_snapshot::buckets>
+    comparison_histogram_{};
+  mutable std::array<counter, stats_snapshot::buckets> size_histogram_{};
+
+  static void add(counter& c, std::uint64_t n) noexcept
+  {
+    c.fetch_add(n, std::memory_order_relaxed);
+  }
+
+  static std::uint64_t load(const counter& c) noexcept
+  {
+    return c.load(std::memory_order_relaxed);
+  }
+
+  //raises c to at least n
+  static void raise(counter& c, std::uint64_t n) noexcept
+  {
+    std::uint64_t old = c.load(std::memory_order_relaxed);
+    while(old < n && !c.compare_exchange_weak(old, n,
+      std::memory_order_relaxed))
+    {
+    }
+  }
+};
+
+}
+
+#endif
@@ -0,0 +1,171 @@
+#ifndef sv_log_set_hpp
+#define sv_log_set_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include "ra/sv_set.hpp"
+
+namespace ra::container {
+
+// A set of unique elements for write-heavy use, made of a large
+// sorted array (the main set) and a small sorted side buffer.
+// New keys go into the side buffer, so an insert only shifts
+// elements of the buffer. Once the buffer is full, it is merged
+// into the main set in one linear pass (see sv_set::merge).
+// Lookups check both parts. Iteration first merges the buffer, so
+// it always sees a single sorted array.
+// Note: begin(), end() and find() may merge the buffer even when
+// called on a const set, so a const set must not be shared between
+// threads without synchronization.
+template <class Key , class Compare = std::less<Key>,
+  class Allocator = std::allocator<Key>>
+class sv_log_set {
+public:
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using allocator_type = Allocator ;
+  using size_type = std::size_t;
+
+  // The type of the main set and of the side buffer.
+  using base_set = sv_set<Key, Compare, Allocator>;
+
+  // The (random-access) iterator types. Iterators are invalidated
+  // by any insertion or erasure, and by compact().
+  using iterator = typename base_set::iterator;
+  using const_iterator = typename base_set::const_iterator;
+
+  // Creates an empty set.
+  // The side buffer is merged once it holds buffer_limit keys. A
+  // limit of zero picks one automatically: the square root of the
+  // size of the main set, but at least 64 keys. This keeps the
+  // amortized cost of an insert at O(sqrt(n)) element moves.
+  explicit sv_log_set ( size_type buffer_limit = 0 ,
+  const Allocator& alloc = Allocator()) : main_(alloc), buffer_(alloc),
+    limit_(buffer_limit) {}
+
+  // Returns the number of elements in the set.
+  size_type size () const noexcept
+  {
+    return main_.size() + buffer_.size();
+  }
+
+  bool empty () const noexcept
+  {
+    return size() == 0;
+  }
+
+  // Returns the number of keys waiting in the side buffer.
+  size_type buffered () const noexcept
+  {
+    return buffer_.size();
+  }
+
+  // Inserts the element x in the set.
+  // Returns true if x was inserted and false if it was already in
+  // the set.
+  bool insert (const key_type & x )
+  {
+    if(main_.find(x) != main_.end() || !buffer_.insert(x).second)
+    {
+      return false;
+    }
+    if(buffer_.size() >= buffer_limit())
+    {
+      compact();
+    }
+    return true;
+  }
+
+  // Erases the element with the key k, if any.
+  // Returns the number of elements erased (zero or one).
+  size_type erase (const key_type & k )
+  {
+    auto pos = buffer_.find(k);
+    if(pos != buffer_.end())
+    {
+      buffer_.erase(pos);
+      return 1;
+    }
+    auto main_pos = main_.find(k);
+    if(main_pos != main_.end())
+    {
+      main_.erase(main_pos);
+      return 1;
+    }
+    return 0;
+  }
+
+  // Returns true if the set holds an element with the key k.
+  // This never merges the side buffer.
+  bool contains (const key_type & k ) const
+  {
+    return main_.find(k) != main_.end() || buffer_.find(k) != buffer_.end();
+  }
+
+  // Searches the container for an element with the key k, after
+  // merging the side buffer. Returns end() if there is none.
+  const_iterator find (const key_type & k ) const
+  {
+    compact();
+    return std::as_const(main_).find(k);
+  }
+
+  // Returns iterators over all the elements in sorted order, after
+  // merging the side buffer.
+  const_iterator begin () const
+  {
+    compact();
+    return std::as_const(main_).begin();
+  }
+  const_iterator end () const
+  {
+    compact();
+    return std::as_const(main_).end();
+  }
+
+  // Merges the side buffer into the main set.
+  void compact () const
+  {
+    if(buffer_.size() != 0)
+    {
+      main_.merge(std::move(buffer_));
+    }
+  }
+
+  // Erases any elements in the container.
+  void clear () noexcept
+  {
+    main_.clear();
+    buffer_.clear();
+  }
+
+  // Reserves storage in the main set for at least n elements.
+  void reserve ( size_type n )
+  {
+    main_.reserve(n);
+  }
+
+  // Returns the number of buffered keys that triggers a merge.
+  size_type buffer_limit () const
+  {
+    if(limit_ != 0)
+    {
+      return limit_;
+    }
+    return std::max<size_type>(64,
+      static_cast<size_type>(std::sqrt(double(main_.size()))));
+  }
+
+private:
+  mutable base_set main_;
+  mutable base_set buffer_;
+  size_type limit_;
+};
+
+}
+
+#endif
@@ -0,0 +1,532 @@
+#ifndef sv_map_hpp
+#define sv_map_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "ra/sv_set.hpp"
+
+namespace ra::container {
+
+// A class representing a map from unique keys to values (which uses
+// two sorted arrays).
+// The keys are kept in an sv_set, and the mapped values in a
+// separate array in the same order (structure of arrays), so a
+// lookup searches only the dense array of keys and reads a value
+// only once its key is found. The keys are located with an object of
+// type Search, and both arrays grow as directed by Growth, as for
+// sv_set.
+// Since a key and its value are not stored together, the iterators
+// refer to the pair of them through a proxy: *it is a
+// std::pair<const Key&, T&>, and it->first and it->second work as
+// usual.
+// Inserting or erasing shifts the elements after the position in
+// both arrays, and invalidates all iterators.
+template <class Key , class T , class Compare = std::less<Key>,
+  class Allocator = std::allocator<std::pair<const Key, T>>,
+  class Search = binary_search_policy, class Growth = geometric_growth<>>
+class sv_map {
+  using key_allocator = typename std::allocator_traits<Allocator>::
+    template rebind_alloc<Key>;
+  using mapped_allocator = typename std::allocator_traits<Allocator>::
+    template rebind_alloc<T>;
+
+public:
+
+  using key_type = Key ;
+  using mapped_type = T ;
+  using value_type = std::pair<Key, T>;
+  using key_compare = Compare ;
+  using allocator_type = Allocator ;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+
+  // The type of the sorted array of keys.
+  using key_set = sv_set<Key, Compare, key_allocator, Search, Growth>;
+
+  // A dummy type used to indicate that the keys in a range are both
+  // ordered and unique.
+  using ordered_and_unique_range =
+    typename key_set::ordered_and_unique_range;
+
+  // A random-access iterator over the entries of the map, referring
+  // to the key and the value of an entry by a pair of pointers.
+  template <bool Const>
+  class basic_iterator {
+    using mapped_pointer = std::conditional_t<Const, const T*, T*>;
+    using mapped_reference = std::conditional_t<Const, const T&, T&>;
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::pair<Key, T>;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::pair<const Key&, mapped_reference>;
+
+    // The result of operator->, which holds the pair of references.
+    struct pointer {
+      reference ref;
+      const reference* operator->() const noexcept { return &ref; }
+    };
+
+    basic_iterator () noexcept : key_(nullptr), value_(nullptr) {}
+
+    // An iterator converts to a const_iterator.
+    template <bool C = Const, class = std::enable_if_t<C>>
+    basic_iterator (const basic_iterator<false>& other ) noexcept :
+      key_(other.key_), value_(other.value_) {}
+
+    // Returns the key and the value of the entry.
+    const Key& key () const noexcept { return *key_; }
+    mapped_reference value () const noexcept { return *value_; }
+
+    reference operator*() const noexcept { return reference(*key_, *value_); }
+    pointer operator->() const noexcept { return pointer{**this}; }
+    reference operator[](difference_type n) const noexcept
+    {
+      return *(*this + n);
+    }
+
+    basic_iterator& operator++() noexcept { ++key_; ++value_; return *this; }
+    basic_iterator& operator--() noexcept { --key_; --value_; return *this; }
+    basic_iterator operator++(int) noexcept
+    {
+      basic_iterator tmp(*this);
+      ++*this;
+      return tmp;
+    }
+    basic_iterator operator--(int) noexcept
+    {
+      basic_iterator tmp(*this);
+      --*this;
+      return tmp;
+    }
+    basic_iterator& operator+=(difference_type n) noexcept
+    {
+      key_ += n;
+      value_ += n;
+      return *this;
+    }
+    basic_iterator& operator-=(difference_type n) noexcept
+    {
+      return *this += -n;
+    }
+    friend basic_iterator operator+(basic_iterator it, difference_type n)
+      noexcept
+    {
+      return it += n;
+    }
+    friend basic_iterator operator+(difference_type n, basic_iterator it)
+      noexcept
+    {
+      return it += n;
+    }
+    friend basic_iterator operator-(basic_iterator it, difference_type n)
+      noexcept
+    {
+      return it -= n;
+    }
+    friend difference_type operator-(const basic_iterator& a,
+      const basic_iterator& b) noexcept
+    {
+      return a.key_ - b.key_;
+    }
+
+    friend bool operator==(const basic_iterator& a, const basic_iterator& b)
+      noexcept { return a.key_ == b.key_; }
+    friend bool operator!=(const basic_iterator& a, const basic_iterator& b)
+      noexcept { return a.key_ != b.key_; }
+    friend bool operator<(const basic_iterator& a, const basic_iterator& b)
+      noexcept { return a.key_ < b.key_; }
+    friend bool operator>(const basic_iterator& a, const basic_iterator& b)
+      noexcept { return a.key_ > b.key_; }
+    friend bool operator<=(const basic_iterator& a, const basic_iterator& b)
+      noexcept { return a.key_ <= b.key_; }
+    friend bool operator>=(const basic_iterator& a, const basic_iterator& b)
+      noexcept { return a.key_ >= b.key_; }
+
+  private:
+    friend class sv_map;
+    friend class basic_iterator<!Const>;
+
+    basic_iterator (const Key* key , mapped_pointer value ) noexcept :
+      key_(key), value_(value) {}
+
+    const Key* key_;
+    mapped_pointer value_;
+  };
+
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  // Creates an empty map.
+  sv_map () = default;
+
+  // Creates an empty map that orders its keys with comp.
+  explicit sv_map (const Compare& comp ,
+  const Allocator& alloc = Allocator()) : keys_(comp, key_allocator(alloc)),
+    values_(mapped_allocator(alloc)) {}
+
+  // Creates a map holding the n keys starting at keys, which must be
+  // both ordered and unique with respect to comp, and the n values
+  // starting at values, in the same order.
+  // Otherwise, the behavior is undefined.
+  template <class KeyIterator , class ValueIterator >
+  sv_map ( ordered_and_unique_range , KeyIterator keys ,
+  ValueIterator values , size_type n , const Compare& comp = Compare(),
+  const Allocator& alloc = Allocator()) :
+    keys_(ordered_and_unique_range(), keys, n, comp, key_allocator(alloc)),
+    values_(mapped_allocator(alloc))
+  {
+    values_.reserve(keys_.capacity());
+    for(size_type i = 0; i < n; ++i, ++values)
+    {
+      values_.push_back(*values);
+    }
+  }
+
+  // Creates a map holding the (key, value) pairs in the range
+  // [first, last), which need not be ordered or unique. Of the pairs
+  // with equivalent keys, only the first one in the range is kept
+  // (as with repeated insertion).
+  // The pairs are sorted once, and then split into the two arrays.
+  template <class InputIterator , class = typename
+    std::iterator_traits<InputIterator>::iterator_category>
+  sv_map ( InputIterator first , InputIterator last ,
+  const Compare& comp = Compare(), const Allocator& alloc = Allocator()) :
+    sv_map(comp, alloc)
+  {
+    std::vector<value_type> pairs(first, last);
+    std::stable_sort(pairs.begin(), pairs.end(),
+      [&](const value_type& a, const value_type& b) {
+        return comp(a.first, b.first);
+      });
+    pairs.erase(std::unique(pairs.begin(), pairs.end(),
+      [&](const value_type& a, const value_type& b) {
+        return !comp(a.first, b.first);
+      }), pairs.end());
+    auto key_of = [](value_type& p) -> Key&& { return std::move(p.first); };
+    auto value_of = [](value_type& p) -> T&& { return std::move(p.second); };
+    std::vector<Key> keys;
+    keys.reserve(pairs.size());
+    std::transform(pairs.begin(), pairs.end(), std::back_inserter(keys),
+      key_of);
+    keys_ = key_set(ordered_and_unique_range(),
+      std::make_move_iterator(keys.begin()), keys.size(), comp,
+      key_allocator(alloc));
+    values_.reserve(pairs.size());
+    std::transform(pairs.begin(), pairs.end(), std::back_inserter(values_),
+      value_of);
+  }
+
+  // Creates a map holding the pairs of il (see above).
+  sv_map ( std::initializer_list<value_type> il ,
+  const Compare& comp = Compare(), const Allocator& alloc = Allocator()) :
+    sv_map(il.begin(), il.end(), comp, alloc) {}
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return keys_.key_comp();
+  }
+
+  // Returns the sorted array of keys.
+  const key_set& keys () const noexcept
+  {
+    return keys_;
+  }
+
+  // Returns a pointer to the array of values, in the order of the
+  // keys.
+  const T* values () const noexcept { return values_.data(); }
+  T* values () noexcept { return values_.data(); }
+
+  iterator begin () noexcept { return make_iterator(0); }
+  iterator end () noexcept { return make_iterator(size()); }
+  const_iterator begin () const noexcept { return make_iterator(0); }
+  const_iterator end () const noexcept { return make_iterator(size()); }
+  const_iterator cbegin () const noexcept { return begin(); }
+  const_iterator cend () const noexcept { return end(); }
+
+  // Returns the number of entries in the map.
+  size_type size () const noexcept
+  {
+    return keys_.size();
+  }
+
+  bool empty () const noexcept
+  {
+    return keys_.size() == 0;
+  }
+
+  // Returns the number of entries for which storage is available.
+  size_type capacity () const noexcept
+  {
+    return keys_.capacity();
+  }
+
+  // Reserves storage in both arrays for at least n entries.
+  void reserve ( size_type n )
+  {
+    keys_.reserve(n);
+    values_.reserve(keys_.capacity());
+  }
+
+  // Erases all entries in the map.
+  void clear () noexcept
+  {
+    keys_.clear();
+    values_.clear();
+  }
+
+  // Inserts an entry with the key k and a value constructed from
+  // args, if the map does not hold the key k already. Otherwise, the
+  // map is not modified, and args are not moved from.
+  // Returns an iterator referring to the entry with the key k, and
+  // true if it was inserted.
+  // The position is found by a binary search, as for sv_set::insert.
+  template <class... Args >
+  std::pair<iterator, bool> try_emplace (const key_type & k ,
+  Args&&... args )
+  {
+    size_type i = keys_.insert(k).first - keys_.begin();
+    if(i == size())
+    {
+      return std::make_pair(find(k), false);
+    }
+    try
+    {
+      if(values_.capacity() < keys_.capacity())
+      {
+        //follow the growth policy of the keys
+        values_.reserve(keys_.capacity());
+      }
+      values_.emplace(values_.begin() + i, std::forward<Args>(args)...);
+    } catch(...)
+    {
+      keys_.erase(keys_.begin() + i);
+      throw;
+    }
+    return std::make_pair(make_iterator(i), true);
+  }
+
+  // Inserts the pair p, if the map does not hold its key already.
+  std::pair<iterator, bool> insert (const value_type & p )
+  {
+    return try_emplace(p.first, p.second);
+  }
+
+  std::pair<iterator, bool> insert ( value_type && p )
+  {
+    return try_emplace(p.first, std::move(p.second));
+  }
+
+  // Inserts an entry with the key k and the value v, or assigns v to
+  // the value of k if the map holds k already.
+  template <class M >
+  std::pair<iterator, bool> insert_or_assign (const key_type & k , M&& v )
+  {
+    iterator pos = find(k);
+    if(pos != end())
+    {
+      pos.value() = std::forward<M>(v);
+      return std::make_pair(pos, false);
+    }
+    return try_emplace(k, std::forward<M>(v));
+  }
+
+  // Returns the value of the key k, inserting k with a
+  // value-initialized value first if the map does not hold it.
+  T& operator[](const key_type & k )
+  {
+    iterator pos = find(k);
+    if(pos != end())
+    {
+      return pos.value();
+    }
+    return try_emplace(k).first.value();
+  }
+
+  // Returns the value of the key k.
+  // Throws std::out_of_range if the map does not hold k.
+  T& at (const key_type & k )
+  {
+    return at_impl(*this, k);
+  }
+  const T& at (const key_type & k ) const
+  {
+    return at_impl(*this, k);
+  }
+
+  // Searches the map for an entry with the key k.
+  // Returns an iterator referring to the entry, or end() if there is
+  // none.
+  // Only the array of keys is searched.
+  iterator find (const key_type & k )
+  {
+    return make_iterator(keys_.find(k) - keys_.begin());
+  }
+  const_iterator find (const key_type & k ) const
+  {
+    return make_iterator(keys_.find(k) - keys_.begin());
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  iterator find (const K & k )
+  {
+    return make_iterator(keys_.find(k) - keys_.begin());
+  }
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  const_iterator find (const K & k ) const
+  {
+    return make_iterator(keys_.find(k) - keys_.begin());
+  }
+
+  // Returns true if the map holds an entry with the key k.
+  bool contains (const key_type & k ) const
+  {
+    return keys_.contains(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  bool contains (const K & k ) const
+  {
+    return keys_.contains(k);
+  }
+
+  // Returns the number of entries with the key k (zero or one).
+  size_type count (const key_type & k ) const
+  {
+    return keys_.count(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  size_type count (const K & k ) const
+  {
+    return keys_.count(k);
+  }
+
+  // Returns an iterator referring to the first entry whose key is
+  // not ordered before k, or end() if there is no such entry.
+  iterator lower_bound (const key_type & k )
+  {
+    return make_iterator(keys_.lower_bound(k) - keys_.begin());
+  }
+  const_iterator lower_bound (const key_type & k ) const
+  {
+    return make_iterator(keys_.lower_bound(k) - keys_.begin());
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  iterator lower_bound (const K & k )
+  {
+    return make_iterator(keys_.lower_bound(k) - keys_.begin());
+  }
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  const_iterator lower_bound (const K & k ) const
+  {
+    return make_iterator(keys_.lower_bound(k) - keys_.begin());
+  }
+
+  // Returns an iterator referring to the first entry whose key k is
+  // ordered before, or end() if there is no such entry.
+  iterator upper_bound (const key_type & k )
+  {
+    return make_iterator(keys_.upper_bound(k) - keys_.begin());
+  }
+  const_iterator upper_bound (const key_type & k ) const
+  {
+    return make_iterator(keys_.upper_bound(k) - keys_.begin());
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  iterator upper_bound (const K & k )
+  {
+    return make_iterator(keys_.upper_bound(k) - keys_.begin());
+  }
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  const_iterator upper_bound (const K & k ) const
+  {
+    return make_iterator(keys_.upper_bound(k) - keys_.begin());
+  }
+
+  // Erases the entries in the range [first, last).
+  // Returns an iterator referring to the entry that followed them.
+  iterator erase ( const_iterator first , const_iterator last )
+  {
+    size_type lo = first - begin();
+    size_type hi = last - begin();
+    keys_.erase(keys_.begin() + lo, keys_.begin() + hi);
+    values_.erase(values_.begin() + lo, values_.begin() + hi);
+    return make_iterator(lo);
+  }
+
+  // Erases the entry referenced by pos.
+  iterator erase ( const_iterator pos )
+  {
+    return erase(pos, pos + 1);
+  }
+
+  // Erases the entry with the key k, if any.
+  // Returns the number of entries erased (zero or one).
+  size_type erase (const key_type & k )
+  {
+    const_iterator pos = find(k);
+    if(pos == end())
+    {
+      return 0;
+    }
+    erase(pos);
+    return 1;
+  }
+
+  void swap ( sv_map & x ) noexcept(noexcept(std::declval<key_set&>().swap(
+    std::declval<key_set&>())))
+  {
+    keys_.swap(x.keys_);
+    values_.swap(x.values_);
+  }
+
+private:
+  key_set keys_;
+  std::vector<T, mapped_allocator> values_;
+
+  iterator make_iterator(size_type i) noexcept
+  {
+    return iterator(keys_.begin() + i, values_.data() + i);
+  }
+  const_iterator make_iterator(size_type i) const noexcept
+  {
+    return const_iterator(keys_.begin() + i, values_.data() + i);
+  }
+
+  template <class Map>
+  static auto& at_impl(Map& m, const key_type& k)
+  {
+    auto pos = m.find(k);
+    if(pos == m.end())
+    {
+      throw std::out_of_range("sv_map::at: key not found");
+    }
+    return pos.value();
+  }
+};
+
+}
+
+#endif
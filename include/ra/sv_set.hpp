@@ -3,17 +3,105 @@
 
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <algorithm>
-// #include <utility>
+#include <iterator>
+#include <initializer_list>
+#include <vector>
+#include <utility>
 #include <cassert>
+#include "ra/parallel_sort.hpp"
+#include "ra/simd_search.hpp"
+#include "ra/search_policy.hpp"
+#include "ra/relocation.hpp"
+#include "ra/stats_policy.hpp"
 
 
 namespace ra::container {
 
+namespace detail {
+
+// Holds an object of type T, deriving from T when it is an empty
+// class so that it takes no space (the empty-base optimization).
+// The Tag only keeps two holders of the same type apart.
+template <class T, class Tag,
+  bool = std::is_empty_v<T> && !std::is_final_v<T>>
+class ebo_holder : private T {
+public:
+  ebo_holder() = default;
+  explicit ebo_holder(const T& value) : T(value) {}
+  explicit ebo_holder(T&& value) : T(std::move(value)) {}
+  T& get() noexcept { return *this; }
+  const T& get() const noexcept { return *this; }
+};
+
+template <class T, class Tag>
+class ebo_holder<T, Tag, false> {
+public:
+  ebo_holder() = default;
+  explicit ebo_holder(const T& value) : value_(value) {}
+  explicit ebo_holder(T&& value) : value_(std::move(value)) {}
+  T& get() noexcept { return value_; }
+  const T& get() const noexcept { return value_; }
+private:
+  T value_;
+};
+
+struct compare_tag {};
+struct allocator_tag {};
+struct search_tag {};
+struct growth_tag {};
+struct stats_tag {};
+
+}
+
+// Growth policies for sv_set (its fifth template parameter).
+// When an insertion needs more room than the set has, the new
+// capacity is Growth()(capacity, required), or required if that is
+// larger.
+// geometric_growth multiplies the capacity by Num / Den and adds
+// one, so a run of single inserts reallocates only O(log n) times.
+// A smaller factor wastes less memory; a larger one copies less.
+template <std::size_t Num = 2, std::size_t Den = 1>
+struct geometric_growth {
+  static_assert(Den > 0 && Num > Den, "the capacity must grow");
+
+  std::size_t operator()(std::size_t capacity ,
+  std::size_t required ) const noexcept
+  {
+    return std::max(required, capacity + capacity / Den * (Num - Den) + 1);
+  }
+};
+
 // A class representing a set of unique elements (which uses
 // a sorted array).
-template <class Key , class Compare = std::less<Key>>
-class sv_set {
+// The storage for the elements is obtained from an object of type
+// Allocator, which is propagated on copy, move and swap as its
+// std::allocator_traits direct.
+// Lookups locate keys with an object of type Search (see
+// ra/search_policy.hpp), which may keep a model of the elements; it
+// is told whenever the elements change.
+// The capacity grows as directed by an object of type Growth.
+// Elements of trivially relocatable types (see ra/relocation.hpp)
+// are moved with memmove when the set grows, and when an insertion
+// or erasure shifts the elements after it, provided that the
+// allocator is std::allocator or std::pmr::polymorphic_allocator.
+// Lookups, element moves, reallocations and changes of size are
+// reported to an object of type Stats (see ra/stats_policy.hpp); the
+// default ra::util::no_stats ignores them.
+// The comparison, allocator, search, growth and statistics objects
+// are stored as empty bases when they are stateless, so such a set
+// is three pointers wide.
+template <class Key , class Compare = std::less<Key>,
+  class Allocator = std::allocator<Key>,
+  class Search = binary_search_policy, class Growth = geometric_growth<>,
+  class Stats = ra::util::no_stats>
+class sv_set :
+  private detail::ebo_holder<Compare, detail::compare_tag>,
+  private detail::ebo_holder<Allocator, detail::allocator_tag>,
+  private detail::ebo_holder<Search, detail::search_tag>,
+  private detail::ebo_holder<Growth, detail::growth_tag>,
+  private detail::ebo_holder<Stats, detail::stats_tag> {
 public:
 
   // A dummy type used to indicate that elements in a range
@@ -29,6 +117,19 @@ public:
   // This is simply an alias for the template parameter Compare.
   using key_compare = Compare ;
 
+  // The type of the allocator used to obtain storage for elements.
+  // This is simply an alias for the template parameter Allocator.
+  using allocator_type = Allocator ;
+
+  // The type of the object used to locate keys.
+  using search_policy_type = Search ;
+
+  // The type of the object that chooses the capacity to grow to.
+  using growth_policy_type = Growth ;
+
+  // The type of the object that collects statistics.
+  using stats_policy_type = Stats ;
+
   // An unsigned integral type used to represent sizes.
   using size_type = std::size_t;
 
@@ -48,7 +149,17 @@ public:
   // with a capacity of zero (i.e., no allocated storage for
   // elements).
   sv_set () noexcept( std::is_nothrow_default_constructible_v <
-  value_type >): start_(nullptr), finish_(nullptr), end_(nullptr) {}
+  value_type >): sv_set(Allocator()) {}
+
+  // Creates an empty set that obtains its storage from alloc.
+  explicit sv_set (const Allocator& alloc ) noexcept :
+    alloc_holder(alloc), start_(nullptr), finish_(nullptr), end_(nullptr) {}
+
+  // Creates an empty set that orders its elements with comp (a
+  // copy of which is kept and used by every operation).
+  explicit sv_set (const Compare& comp ,
+  const Allocator& alloc = Allocator()) : compare_holder(comp),
+    alloc_holder(alloc), start_(nullptr), finish_(nullptr), end_(nullptr) {}
 
   // Create a set containing the elements specified by the
   // range [first, first + n), where the elements in
@@ -64,18 +175,60 @@ public:
   // not require an ordered and unique range).
   template <class InputIterator >
   sv_set ( ordered_and_unique_range , InputIterator first ,
-  std::size_t n )
+  std::size_t n , const Allocator& alloc = Allocator())
+    : sv_set(ordered_and_unique_range(), first, n, Compare(), alloc) {}
+
+  // As above, for a range ordered with respect to comp, which the
+  // set keeps and uses as its comparison object.
+  template <class InputIterator >
+  sv_set ( ordered_and_unique_range , InputIterator first ,
+  std::size_t n , const Compare& comp ,
+  const Allocator& alloc = Allocator()) : sv_set(comp, alloc)
   {
-    start_ = static_cast<Key *>(::operator new(n * sizeof(InputIterator)));
+    start_ = allocate(n);
     end_ = start_ + n;
     try
     {
-      finish_ = std::uninitialized_copy_n(first, n, start_);
+      finish_ = uninitialized_copy_a(first, n, start_);
     } catch(...)
     {
-      ::operator delete(start_);
+      deallocate(start_, n);
       throw;
     }
+    record_size();
+  }
+
+  // Create a set containing the elements specified by the
+  // range [first, last), where the elements in the range need
+  // not be ordered or unique.
+  // The elements are copied into a buffer of exactly the size
+  // of the range, and then sorted and deduplicated in place.
+  // Elements that are equivalent to an earlier element in the
+  // sorted order are dropped. The capacity of the set is the
+  // length of the range.
+  template <class InputIterator , class = typename
+    std::iterator_traits<InputIterator>::iterator_category>
+  sv_set ( InputIterator first , InputIterator last ,
+  const Allocator& alloc = Allocator()) : sv_set(alloc)
+  {
+    assign_unsorted(first, last, [this](iterator b, iterator e) {
+      std::sort(b, e, compare());
+    });
+  }
+
+  // Same as the constructor above, except that the sort is
+  // spread over the threads requested by the policy.
+  // For example:
+  //   sv_set<int> s(ra::util::par, keys.begin(), keys.end());
+  template <class InputIterator , class = typename
+    std::iterator_traits<InputIterator>::iterator_category>
+  sv_set (const ra::util::parallel_policy& policy , InputIterator first ,
+  InputIterator last , const Allocator& alloc = Allocator())
+    : sv_set(alloc)
+  {
+    assign_unsorted(first, last, [this, &policy](iterator b, iterator e) {
+      ra::util::parallel_sort(policy, b, e, compare());
+    });
   }
   // Move construction.
   // Creates a new set by moving from the specified set other.
@@ -83,13 +236,20 @@ public:
   // guaranteed to be empty.
   sv_set ( sv_set && other ) noexcept(
   std :: is_nothrow_move_constructible_v < value_type >)
+    : compare_holder(other.compare()),
+      alloc_holder(std::move(other.allocator())),
+      search_holder(std::move(other.search())),
+      growth_holder(other.growth()), stats_holder()
   {
+    other.search().invalidate();
     start_ = other.start_;
     other.start_  = nullptr;
     end_ = other.end_;
     other.end_ = nullptr;
     finish_ = other.finish_;
     other.finish_ = nullptr;
+    record_size();
+    other.record_size();
   }
   // Move assignment.
   // Assigns the value of the specified set other to *this
@@ -97,37 +257,74 @@ public:
   // After the move operation, the source set (i.e., other)
   // is guaranteed to be empty.
   // Precondition: The objects *this and other are distinct.
+  // If the allocator does not propagate on move assignment and
+  // the two allocators differ, the elements are moved one by one
+  // into storage obtained from the allocator of *this.
   sv_set & operator=( sv_set && other ) noexcept(
   std :: is_nothrow_move_assignable_v < value_type >)
   {
       if(this != &other)
       {
+        if constexpr(!alloc_traits::propagate_on_container_move_assignment
+          ::value)
+        {
+          if(!(allocator() == other.allocator()))
+          {
+            clear();
+            reserve(other.size());
+            for(iterator it = other.start_; it != other.finish_; ++it)
+            {
+              construct(finish_, std::move(*it));
+              ++finish_;
+            }
+            other.clear();
+            compare() = other.compare();
+            growth() = other.growth();
+            record_size();
+            return *this;
+          }
+        }
         clear();
-        ::operator delete(start_);
+        deallocate(start_, capacity());
+        if constexpr(alloc_traits::propagate_on_container_move_assignment
+          ::value)
+        {
+          allocator() = std::move(other.allocator());
+        }
+        compare() = other.compare();
+        growth() = other.growth();
+        search() = std::move(other.search());
+        other.search().invalidate();
         start_ = other.start_;
         other.start_ = nullptr;
         finish_ = other.finish_;
         other.finish_ = nullptr;
         end_ = other.end_;
         other.end_ = nullptr;
+        record_size();
+        other.record_size();
       }
       return * this;
   }
 
   // Copy construction.
   // Creates a new set by copying from the specified set other.
-  sv_set (const sv_set & other )
+  sv_set (const sv_set & other ) : compare_holder(other.compare()),
+    alloc_holder(alloc_traits::select_on_container_copy_construction(
+      other.allocator())), search_holder(other.search()),
+    growth_holder(other.growth()), stats_holder()
   {
-    start_ = static_cast<Key*>(::operator new(other.size() * sizeof(Key)));
+    start_ = allocate(other.size());
     end_ = start_ + other.size();
     try
     {
-      finish_ = std::uninitialized_copy(other.start_, other.finish_, start_);
+      finish_ = uninitialized_copy_a(other.start_, other.size(), start_);
     }catch(...)
     {
-      ::operator delete(start_);
+      deallocate(start_, other.size());
       throw;
     }
+    record_size();
   }
 
   // Copy assignment.
@@ -137,11 +334,25 @@ public:
     if(this != &other)
     {
       clear();
+      if constexpr(alloc_traits::propagate_on_container_copy_assignment
+        ::value)
+      {
+        if(!(allocator() == other.allocator()))
+        {
+          //storage from the old allocator cannot be kept
+          deallocate(start_, capacity());
+          start_ = finish_ = end_ = nullptr;
+        }
+        allocator() = other.allocator();
+      }
+      compare() = other.compare();
+      growth() = other.growth();
       if(other.size() > capacity())
       {
         grow(other.size());
       }
-      finish_ = std::uninitialized_copy(other.start_, other.finish_, start_);
+      finish_ = uninitialized_copy_a(other.start_, other.size(), start_);
+      record_size();
     }
     return *this;
   }
@@ -150,13 +361,32 @@ public:
   ~sv_set()
   {
     clear();
-    ::operator delete(start_);
+    deallocate(start_, capacity());
   }
 
   // Returns the comparison object for the container.
   key_compare key_comp () const
   {
-    return comp_;
+    return compare();
+  }
+
+  // Returns a copy of the allocator used by the container.
+  allocator_type get_allocator () const noexcept
+  {
+    return allocator();
+  }
+
+  // Returns the object used to locate keys.
+  const search_policy_type& get_search_policy () const noexcept
+  {
+    return search();
+  }
+
+  // Returns the object that collects statistics (for example, to
+  // take a snapshot() of a ra::util::container_stats).
+  const stats_policy_type& get_stats () const noexcept
+  {
+    return stats();
   }
 
   // Returns an iterator referring to the first element in the
@@ -247,38 +477,324 @@ public:
   // and first elements set to false and end(), respectively.
   std::pair<iterator,bool> insert (const key_type & x )
   {
-    
-    if(finish_ == end_)
+    return insert_unique(x);
+  }
+
+  // As above, moving x into the set if it is inserted. A key that
+  // owns its resources, such as a std::unique_ptr, can be inserted
+  // only this way.
+  std::pair<iterator,bool> insert ( key_type && x )
+  {
+    return insert_unique(std::move(x));
+  }
+
+  // Inserts a key constructed from args, as insert(key_type&&).
+  // The key is constructed before the set is searched, and is
+  // destroyed if it is already in the set.
+  template <class... Args >
+  std::pair<iterator,bool> emplace ( Args&&... args )
+  {
+    return insert_unique(Key(std::forward<Args>(args)...));
+  }
+
+  // Inserts the elements in the range [first, last) in the set.
+  // Elements that are already in the set (or that are repeated
+  // in the range) are not inserted again.
+  // The range does not need to be ordered or unique. It is copied
+  // to a temporary buffer, sorted and deduplicated, and then merged
+  // into the set in a single backwards pass. At most one
+  // reallocation is performed. The buffer comes from std::allocator,
+  // not from the allocator of the set, so that it leaves nothing
+  // behind in an arena that never frees.
+  // If an exception is thrown during the merge, the set is cleared.
+  // Time complexity: O(k log k + n) for k new and n old elements.
+  template <class InputIterator >
+  void insert ( InputIterator first , InputIterator last )
+  {
+    std::vector<Key> batch(first, last);
+    if(batch.empty())
     {
-      grow(2 * capacity() + 1);
+      return;
     }
 
-    //did not find element
-    if(find(x) == end())
-    {
-      
-      //to be used for finding where to put the element
-      iterator pos = start_;
+    //sort the batch and remove repeated keys
+    std::sort(batch.begin(), batch.end(), compare());
+    batch.erase(std::unique(batch.begin(), batch.end(),
+      [this](const Key& a, const Key& b) { return !compare()(a, b); }),
+      batch.end());
 
-      //while not reaching at the end of the container
-      while(pos!= end() && Compare()(*pos,x) )
+    //drop keys that are already in the set (merge walk)
+    auto keep = batch.begin();
+    const Key* pos = start_;
+    for(auto it = batch.begin(); it != batch.end(); ++it)
+    {
+      while(pos != finish_ && compare()(*pos, *it))
       {
         ++pos;
       }
-      
-      //shift elements to make room for the element
-      std::move_backward(pos, finish_, finish_+1);
+      if(pos == finish_ || compare()(*it, *pos))
+      {
+        if(keep != it)
+        {
+          *keep = std::move(*it);
+        }
+        ++keep;
+      }
+    }
+    batch.erase(keep, batch.end());
 
-      //insert element at that location
-      *pos = x;
+    merge_back(std::make_move_iterator(batch.begin()),
+      std::make_move_iterator(batch.end()));
+    search().invalidate();
+    record_size();
+  }
 
-      ++finish_;
-      
-      return std::make_pair(pos,true);
+  // Inserts the elements in the initializer list il in the set.
+  // Equivalent to insert(il.begin(), il.end()).
+  void insert ( std::initializer_list<key_type> il )
+  {
+    insert(il.begin(), il.end());
+  }
+
+  // Moves the elements of other that are not already in *this into
+  // *this, leaving other empty.
+  // Both sets are already sorted, so they are combined by a single
+  // backwards merge. If *this is empty, or if only other has room
+  // for the result, the storage of other is taken over instead of
+  // allocating (provided the allocators compare equal).
+  // Time complexity: O(n + m).
+  void merge ( sv_set&& other )
+  {
+    if(this == &other || other.size() == 0)
+    {
+      return;
+    }
+    bool can_steal = alloc_traits::propagate_on_container_swap::value ||
+      allocator() == other.allocator();
+    if(size() == 0 && can_steal)
+    {
+      swap(other);
+      return;
     }
 
-    //element found, return the end() with false
-    return std::make_pair(end(),false);
+    //drop from other the keys that *this already holds
+    iterator keep = other.start_;
+    const_iterator pos = start_;
+    for(iterator it = other.start_; it != other.finish_; ++it)
+    {
+      pos = gallop(pos, const_iterator(finish_), *it, compare());
+      if(pos == finish_ || compare()(*it, *pos))
+      {
+        if(keep != it)
+        {
+          *keep = std::move(*it);
+        }
+        ++keep;
+      }
+    }
+    other.destroy(keep, other.finish_);
+    other.finish_ = keep;
+    other.search().invalidate();
+
+    size_type total = size() + other.size();
+    if(can_steal && capacity() < total && other.capacity() >= total)
+    {
+      //the merge is symmetric, so merge into the other buffer
+      swap(other);
+    }
+    merge_back(std::make_move_iterator(other.start_),
+      std::make_move_iterator(other.finish_));
+    search().invalidate();
+    other.clear();
+    record_size();
+  }
+
+  // Returns the union of the sets a and b.
+  // The result is reserved up front and filled by one merge pass.
+  // When one set is much smaller than the other, the runs of the
+  // larger set between the keys of the smaller are found by
+  // galloping (exponential) search and copied in bulk.
+  friend sv_set set_union (const sv_set& a , const sv_set& b )
+  {
+    sv_set result(a.allocator());
+    result.compare() = a.compare();
+    result.reserve(a.size() + b.size());
+    const sv_set& big = a.size() >= b.size() ? a : b;
+    const sv_set& small = a.size() >= b.size() ? b : a;
+    const Compare& comp = a.compare();
+    if(lopsided(small.size(), big.size()))
+    {
+      const_iterator i = big.start_;
+      for(const_iterator j = small.start_; j != small.finish_; ++j)
+      {
+        const_iterator p = gallop(i, big.end(), *j, comp);
+        result.append(i, p);
+        i = (p != big.finish_ && !comp(*j, *p)) ? p + 1 : p;
+        result.append(j, j + 1);
+      }
+      result.append(i, big.end());
+      result.record_size();
+      return result;
+    }
+    const_iterator i = a.start_;
+    const_iterator j = b.start_;
+    while(i != a.finish_ && j != b.finish_)
+    {
+      if(comp(*i, *j))
+      {
+        result.append(i, i + 1);
+        ++i;
+      }
+      else
+      {
+        if(!comp(*j, *i))
+        {
+          ++i;
+        }
+        result.append(j, j + 1);
+        ++j;
+      }
+    }
+    result.append(i, a.end());
+    result.append(j, b.end());
+    result.record_size();
+    return result;
+  }
+
+  // Returns the intersection of the sets a and b.
+  // For uint32_t keys ordered by std::less, blocks of keys are
+  // compared with SIMD instructions. Otherwise, the sets are merged,
+  // galloping through the larger set if the sizes are lopsided.
+  friend sv_set set_intersection (const sv_set& a , const sv_set& b )
+  {
+    sv_set result(a.allocator());
+    result.compare() = a.compare();
+    result.reserve(std::min(a.size(), b.size()));
+    const Compare& comp = a.compare();
+    const sv_set& big = a.size() >= b.size() ? a : b;
+    const sv_set& small = a.size() >= b.size() ? b : a;
+    if(lopsided(small.size(), big.size()))
+    {
+      const_iterator i = big.start_;
+      for(const_iterator j = small.start_; j != small.finish_; ++j)
+      {
+        i = gallop(i, big.end(), *j, comp);
+        if(i != big.finish_ && !comp(*j, *i))
+        {
+          result.append(j, j + 1);
+        }
+      }
+      result.record_size();
+      return result;
+    }
+    if constexpr(ra::util::simd_intersectable_v<Key, Compare>)
+    {
+      result.finish_ += ra::util::simd_intersect(a.start_, a.size(),
+        b.start_, b.size(), result.start_);
+      result.record_size();
+      return result;
+    }
+    const_iterator i = a.start_;
+    const_iterator j = b.start_;
+    while(i != a.finish_ && j != b.finish_)
+    {
+      if(comp(*i, *j))
+      {
+        ++i;
+      }
+      else if(comp(*j, *i))
+      {
+        ++j;
+      }
+      else
+      {
+        result.append(i, i + 1);
+        ++i;
+        ++j;
+      }
+    }
+    result.record_size();
+    return result;
+  }
+
+  // Returns the elements of a that are not in b.
+  // Gallops through whichever set is much larger, if either is.
+  friend sv_set set_difference (const sv_set& a , const sv_set& b )
+  {
+    sv_set result(a.allocator());
+    result.compare() = a.compare();
+    result.reserve(a.size());
+    const Compare& comp = a.compare();
+    const_iterator i = a.start_;
+    const_iterator j = b.start_;
+    if(lopsided(b.size(), a.size()))
+    {
+      //copy the runs of a between the keys of b
+      for(; j != b.finish_; ++j)
+      {
+        const_iterator p = gallop(i, a.end(), *j, comp);
+        result.append(i, p);
+        i = (p != a.finish_ && !comp(*j, *p)) ? p + 1 : p;
+      }
+      result.append(i, a.end());
+      result.record_size();
+      return result;
+    }
+    if(lopsided(a.size(), b.size()))
+    {
+      for(; i != a.finish_; ++i)
+      {
+        j = gallop(j, b.end(), *i, comp);
+        if(j == b.finish_ || comp(*i, *j))
+        {
+          result.append(i, i + 1);
+        }
+      }
+      result.record_size();
+      return result;
+    }
+    while(i != a.finish_ && j != b.finish_)
+    {
+      if(comp(*i, *j))
+      {
+        result.append(i, i + 1);
+        ++i;
+      }
+      else
+      {
+        if(!comp(*j, *i))
+        {
+          ++i;
+        }
+        ++j;
+      }
+    }
+    result.append(i, a.end());
+    result.record_size();
+    return result;
+  }
+
+  // Returns true if every element of b is also in a.
+  friend bool includes (const sv_set& a , const sv_set& b )
+  {
+    if(b.size() > a.size())
+    {
+      return false;
+    }
+    const Compare& comp = a.compare();
+    const_iterator i = a.start_;
+    for(const_iterator j = b.start_; j != b.finish_; ++j)
+    {
+      i = lopsided(b.size(), a.size()) ? gallop(i, a.end(), *j, comp)
+        : std::find_if_not(i, a.end(),
+          [&](const Key& x) { return comp(x, *j); });
+      if(i == a.finish_ || comp(*j, *i))
+      {
+        return false;
+      }
+      ++i;
+    }
+    return true;
   }
 
   // Erases the element referenced by pos from the container.
@@ -287,31 +803,113 @@ public:
   // end() otherwise.
   iterator erase ( const_iterator pos )
   {
-    iterator iter = find(*pos);
-    
-    std::destroy_at(iter);
-
-    //shift elements left, so fill void
-    std::move(iter+1, finish_, iter);
-
-    //destroy the last guy
-    std::destroy_at(finish_);
+    return erase(pos, pos + 1);
+  }
 
-   --finish_;
+  // Erases the elements in the range [first, last), shifting the
+  // elements after it down once.
+  // Returns an iterator referring to the element that followed the
+  // erased ones, or end() if there is no such element.
+  iterator erase ( const_iterator first , const_iterator last )
+  {
+    iterator lo = to_iterator(first);
+    iterator hi = to_iterator(last);
+    if(lo == hi)
+    {
+      return lo;
+    }
+    record_moves(finish_ - hi);
+    if constexpr(relocatable)
+    {
+      destroy(lo, hi);
+      detail::relocate(hi, finish_ - hi, lo);
+      finish_ -= hi - lo;
+    }
+    else
+    {
+      //shift elements left, then destroy the vacated tail
+      iterator new_finish = std::move(hi, finish_, lo);
+      destroy(new_finish, finish_);
+      finish_ = new_finish;
+    }
+    search().invalidate();
+    record_size();
+    return lo;
+  }
 
-    //check if the folowing value exists
-    if(iter != nullptr)
+  // Erases the elements with the keys in the range [first, last),
+  // which must be sorted with respect to key_comp() (repeated keys
+  // and keys that are not in the set are allowed).
+  // The keys are matched by a merge walk that gallops over runs of
+  // elements that are kept, and the kept elements are compacted in
+  // the same pass, so each moves at most once.
+  // Returns the number of elements erased.
+  // Time complexity: O(k log(n / k)) comparisons and O(n) moves for
+  // k keys and n elements.
+  template <class InputIterator >
+  size_type erase_keys ( InputIterator first , InputIterator last )
+  {
+    //[start_, out) holds the kept elements, and [in, finish_) the
+    //ones not yet moved; each search gallops from where the last one
+    //stopped, found or not, so the searches cover the set only once
+    iterator out = start_;
+    iterator in = start_;
+    iterator from = start_;
+    for(; first != last && from != finish_; ++first)
+    {
+      iterator pos = to_iterator(gallop(from, finish_, *first, compare()));
+      from = pos;
+      if(pos == finish_ || compare()(*first, *pos))
+      {
+        continue;
+      }
+      out = compact(in, pos, out);
+      destroy_erased(pos);
+      in = from = pos + 1;
+    }
+    if(in == out)
     {
-      return iter;
+      return 0;
     }
-    return end();
+    out = compact(in, finish_, out);
+    if constexpr(!relocatable)
+    {
+      destroy(out, finish_);
+    }
+    size_type erased = finish_ - out;
+    finish_ = out;
+    search().invalidate();
+    record_size();
+    return erased;
+  }
+
+  // Erases the elements for which pred returns true, compacting the
+  // kept ones in a single pass.
+  // Returns the number of elements erased.
+  template <class Predicate >
+  friend size_type erase_if ( sv_set& s , Predicate pred )
+  {
+    iterator keep = std::remove_if(s.start_, s.finish_, pred);
+    size_type erased = s.finish_ - keep;
+    s.erase(keep, s.finish_);
+    return erased;
   }
 
   // Swaps the contents of the container with the contents of the
   // container x.
+  // The allocators are swapped only if they propagate on swap;
+  // otherwise they must compare equal.
   void swap ( sv_set& x) noexcept(
   std::is_nothrow_swappable_v<value_type>)
   {
+    using std::swap;
+    if constexpr(alloc_traits::propagate_on_container_swap::value)
+    {
+      swap(allocator(), x.allocator());
+    }
+    swap(compare(), x.compare());
+    swap(search(), x.search());
+    swap(growth(), x.growth());
     Key* tmp_start = x.start_; 
     Key* tmp_finish = x.finish_; 
     Key* tmp_end = x.end_; 
@@ -321,6 +919,8 @@ public:
     end_ = tmp_end;
     x.finish_ = finish_;
     finish_ = tmp_finish;
+    record_size();
+    x.record_size();
   }
 
 
@@ -328,65 +928,706 @@ public:
   // container.
   void clear () noexcept
   {
-    std::destroy(start_, finish_);
+    destroy(start_, finish_);
     finish_ = start_;
+    search().invalidate();
+    record_size();
   }
 
   // Searches the container for an element with the key k.
   // If an element is found, an iterator referencing the element
   // is returned; otherwise, end() is returned.
+  // If the search policy has a filter (see filtered_search_policy),
+  // a key that it rules out is reported absent without a search.
+  // The key is located by the search policy; with the default
+  // binary_search_policy, the search is vectorized for uint32_t,
+  // uint64_t and double keys ordered by std::less.
+  // The overloads taking a K other than key_type (here and in the
+  // lookup functions below) only take part in overload resolution
+  // if Compare::is_transparent names a type. They compare k with
+  // the elements directly, without building a key_type from it.
   iterator find (const key_type & k )
   {
-    //start is the lower bound, finish  is the last element position
-    iterator first = std::lower_bound(start_, finish_, k, Compare());
-
-    if( first != finish_)
-    {if(!(Compare()(k, *first))){ return first;}
-    else{return end();}
-    }
-    return end();
+    return to_iterator(find_impl(k));
   }
 
   const_iterator find (const key_type & k) const
   {
-    return find(k);
+    return find_impl(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  iterator find (const K & k )
+  {
+    return to_iterator(find_impl(k));
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  const_iterator find (const K & k ) const
+  {
+    return find_impl(k);
+  }
+
+  // Returns true if the set holds an element equivalent to k.
+  bool contains (const key_type & k ) const
+  {
+    return find_impl(k) != finish_;
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  bool contains (const K & k ) const
+  {
+    return find_impl(k) != finish_;
+  }
+
+  // Returns the number of elements equivalent to k (zero or one).
+  size_type count (const key_type & k ) const
+  {
+    return contains(k) ? 1 : 0;
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  size_type count (const K & k ) const
+  {
+    return contains(k) ? 1 : 0;
+  }
+
+  // Returns an iterator referring to the first element that is not
+  // ordered before k, or end() if there is no such element.
+  iterator lower_bound (const key_type & k )
+  {
+    return to_iterator(lower_bound_of(k));
+  }
+
+  const_iterator lower_bound (const key_type & k ) const
+  {
+    return lower_bound_of(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  iterator lower_bound (const K & k )
+  {
+    return to_iterator(lower_bound_of(k));
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  const_iterator lower_bound (const K & k ) const
+  {
+    return lower_bound_of(k);
+  }
+
+  // Returns an iterator referring to the first element that k is
+  // ordered before, or end() if there is no such element.
+  iterator upper_bound (const key_type & k )
+  {
+    return to_iterator(upper_bound_of(k));
+  }
+
+  const_iterator upper_bound (const key_type & k ) const
+  {
+    return upper_bound_of(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  iterator upper_bound (const K & k )
+  {
+    return to_iterator(upper_bound_of(k));
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  const_iterator upper_bound (const K & k ) const
+  {
+    return upper_bound_of(k);
+  }
+
+  // Returns the range of elements equivalent to k, which holds at
+  // most one element.
+  std::pair<iterator, iterator> equal_range (const key_type & k )
+  {
+    auto r = equal_range_impl(k);
+    return {to_iterator(r.first), to_iterator(r.second)};
+  }
+
+  std::pair<const_iterator, const_iterator> equal_range (
+  const key_type & k ) const
+  {
+    return equal_range_impl(k);
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  std::pair<iterator, iterator> equal_range (const K & k )
+  {
+    auto r = equal_range_impl(k);
+    return {to_iterator(r.first), to_iterator(r.second)};
+  }
+
+  template <class K , class C = Compare ,
+    class = typename C::is_transparent>
+  std::pair<const_iterator, const_iterator> equal_range (const K & k ) const
+  {
+    return equal_range_impl(k);
+  }
+
+  // Searches the container for each key in the range
+  // [first, last), writing to out the iterator that find would
+  // return for that key, in the same order as the keys.
+  // Returns the output iterator past the last value written.
+  // Unsorted keys are searched in groups, with the binary searches
+  // of a group run in lockstep and the next probe of each prefetched,
+  // so that their cache misses overlap. If the keys are already
+  // sorted, they are instead found by one galloping pass over the
+  // set.
+  // Requires ForwardIterator to be a forward iterator.
+  template <class ForwardIterator , class OutputIterator >
+  OutputIterator find_many ( ForwardIterator first , ForwardIterator last ,
+  OutputIterator out ) const
+  {
+    for_each_lower_bound(first, last,
+      [this, &out](const Key& k, const_iterator pos) {
+        *out++ = (pos != finish_ && !compare()(k, *pos)) ? pos : end();
+      });
+    return out;
+  }
+
+  // Same as find_many, except that the value written to out for
+  // each key is true if the key is in the set and false otherwise.
+  template <class ForwardIterator , class OutputIterator >
+  OutputIterator contains_many ( ForwardIterator first ,
+  ForwardIterator last , OutputIterator out ) const
+  {
+    for_each_lower_bound(first, last,
+      [this, &out](const Key& k, const_iterator pos) {
+        *out++ = pos != finish_ && !compare()(k, *pos);
+      });
+    return out;
   }
 
 private:
-  Compare comp_;
+  using alloc_traits = std::allocator_traits<Allocator>;
+  using compare_holder = detail::ebo_holder<Compare, detail::compare_tag>;
+  using alloc_holder = detail::ebo_holder<Allocator, detail::allocator_tag>;
+  using search_holder = detail::ebo_holder<Search, detail::search_tag>;
+  using growth_holder = detail::ebo_holder<Growth, detail::growth_tag>;
+  using stats_holder = detail::ebo_holder<Stats, detail::stats_tag>;
+
+  //true if the elements may be moved by copying their bytes
+  static constexpr bool relocatable = is_trivially_relocatable_v<Key> &&
+    detail::plain_construct_v<Allocator, Key>;
+
   Key* start_;
   Key* finish_;
   Key* end_;
-  
-  void grow(size_type n)
+
+  Compare& compare() noexcept { return compare_holder::get(); }
+  const Compare& compare() const noexcept { return compare_holder::get(); }
+  Allocator& allocator() noexcept { return alloc_holder::get(); }
+  const Allocator& allocator() const noexcept { return alloc_holder::get(); }
+  Search& search() noexcept { return search_holder::get(); }
+  const Search& search() const noexcept { return search_holder::get(); }
+  Growth& growth() noexcept { return growth_holder::get(); }
+  const Growth& growth() const noexcept { return growth_holder::get(); }
+  const Stats& stats() const noexcept { return stats_holder::get(); }
+
+  void record_size() const noexcept
   {
-    Key * new_start_ = static_cast<Key*>(::operator new(n * sizeof(Key)));
-    size_type old_size = size();
+    stats().resized(size(), capacity());
+  }
+
+  void record_moves(size_type n) const noexcept
+  {
+    stats().moved(n, n * sizeof(Key));
+  }
+
+  //returns the capacity to grow to for at least required elements
+  size_type next_capacity(size_type required) const
+  {
+    return std::max(required, growth()(capacity(), required));
+  }
+
+  Key* allocate(size_type n)
+  {
+    return n != 0 ? alloc_traits::allocate(allocator(), n) : nullptr;
+  }
+
+  void deallocate(Key* p, size_type n) noexcept
+  {
+    if(p != nullptr)
+    {
+      alloc_traits::deallocate(allocator(), p, n);
+    }
+  }
+
+  template <class... Args>
+  void construct(Key* p, Args&&... args)
+  {
+    alloc_traits::construct(allocator(), p, std::forward<Args>(args)...);
+  }
+
+  void destroy(Key* first, Key* last) noexcept
+  {
+    for(; first != last; ++first)
+    {
+      alloc_traits::destroy(allocator(), first);
+    }
+  }
+
+  //constructs copies of [first, first + n) at out, through the
+  //allocator; nothing is left constructed if a copy throws
+  template <class InputIterator>
+  Key* uninitialized_copy_a(InputIterator first, size_type n, Key* out)
+  {
+    Key* cur = out;
     try
     {
-      std::uninitialized_move(start_, finish_, new_start_);
+      for(; n != 0; --n, ++first, ++cur)
+      {
+        construct(cur, *first);
+      }
     } catch(...)
     {
-      ::operator delete(new_start_);
+      destroy(out, cur);
       throw;
     }
-    ::operator delete(start_);
+    return cur;
+  }
+
+  void grow(size_type n)
+  {
+    Key * new_start_ = allocate(n);
+    size_type old_size = size();
+    stats().reallocated(capacity(), n);
+    record_moves(old_size);
+    if constexpr(relocatable)
+    {
+      //the old elements are not destroyed: their bytes now live on
+      //in the new storage
+      detail::relocate(start_, old_size, new_start_);
+    }
+    else
+    {
+      Key* cur = new_start_;
+      try
+      {
+        for(Key* it = start_; it != finish_; ++it, ++cur)
+        {
+          construct(cur, std::move(*it));
+        }
+      } catch(...)
+      {
+        destroy(new_start_, cur);
+        deallocate(new_start_, n);
+        throw;
+      }
+      clear();
+    }
+    deallocate(start_, capacity());
     start_ = new_start_;
     finish_ = start_ + old_size;
     end_ = start_ + n;
+    record_size();
   }
   
-  //helper function - may or may not be used
-  iterator binarySearch(iterator low, iterator high, const key_type & x)
+  //true if a set of size small is so much smaller than one of size
+  //big that galloping beats a linear merge
+  static bool lopsided(size_type small, size_type big)
   {
-    iterator first = std::lower_bound(low, high, x, Compare());
+    return small * 16 < big;
+  }
 
-    if(!(first == high) && !(Compare()(x, *first)));
+  //returns the first element of the sorted range [first, last) that
+  //is not ordered before k, searching outwards from first
+  static const_iterator gallop(const_iterator first, const_iterator last,
+    const Key& k, const Compare& comp)
+  {
+    size_type step = 1;
+    const_iterator hi = first;
+    while(hi != last && comp(*hi, k))
     {
-      return first;
+      first = hi + 1;
+      hi = (size_type(last - hi) > step) ? hi + step : last;
+      step *= 2;
+    }
+    return std::lower_bound(first, hi, k, comp);
+  }
+
+  //copies [first, last) to the end; the storage must already be
+  //reserved and the keys must sort after every element
+  void append(const_iterator first, const_iterator last)
+  {
+    finish_ = uninitialized_copy_a(first, last - first, finish_);
+  }
+
+  //merges the sorted and unique range [first, last), none of whose
+  //keys are in the set, into the set in one pass from the back
+  template <class RandomIt>
+  void merge_back(RandomIt first, RandomIt last)
+  {
+    size_type n = last - first;
+    if(n == 0)
+    {
+      return;
+    }
+    if(size() + n > capacity())
+    {
+      grow(next_capacity(size() + n));
+    }
+
+    //slots at or past finish_ are uninitialized
+    iterator out = finish_ + n;
+    iterator old = finish_;
+    RandomIt in = last;
+    try
+    {
+      while(in != first)
+      {
+        --out;
+        //take the larger of the two tails
+        if(old != start_ && compare()(in[-1], old[-1]))
+        {
+          --old;
+          if(out >= finish_)
+          {
+            construct(out, std::move(*old));
+          }
+          else
+          {
+            *out = std::move(*old);
+          }
+        }
+        else
+        {
+          --in;
+          if(out >= finish_)
+          {
+            construct(out, *in);
+          }
+          else
+          {
+            *out = *in;
+          }
+        }
+      }
+    } catch(...)
+    {
+      destroy(std::max(out + 1, finish_), finish_ + n);
+      clear();
+      throw;
+    }
+    record_moves(finish_ - old);
+    finish_ += n;
+  }
+
+  //copies [first, last) into fresh storage, then sorts and
+  //deduplicates it; only used by the constructors
+  template <class InputIterator, class Sort>
+  void assign_unsorted(InputIterator first, InputIterator last, Sort sort)
+  {
+    using category =
+      typename std::iterator_traits<InputIterator>::iterator_category;
+    if constexpr(!std::is_base_of_v<std::forward_iterator_tag, category>)
+    {
+      //single pass range, so buffer it (outside the allocator of the
+      //set, like the batch of insert()) to learn its length
+      std::vector<Key> tmp(first, last);
+      assign_unsorted(std::make_move_iterator(tmp.begin()),
+        std::make_move_iterator(tmp.end()), sort);
+    }
+    else
+    {
+      size_type n = std::distance(first, last);
+      if(n == 0)
+      {
+        return;
+      }
+      start_ = allocate(n);
+      finish_ = start_;
+      end_ = start_ + n;
+      try
+      {
+        finish_ = uninitialized_copy_a(first, n, start_);
+        sort(start_, finish_);
+        iterator last_unique = std::unique(start_, finish_,
+          [this](const Key& a, const Key& b) { return !compare()(a, b); });
+        destroy(last_unique, finish_);
+        finish_ = last_unique;
+      } catch(...)
+      {
+        clear();
+        deallocate(start_, n);
+        start_ = finish_ = end_ = nullptr;
+        throw;
+      }
+      record_size();
+    }
+  }
+
+  iterator to_iterator(const_iterator pos) noexcept
+  {
+    return start_ + (pos - start_);
+  }
+
+  //inserts x (a const key_type& or a key_type&&) unless it is in
+  //the set already
+  template <class K>
+  std::pair<iterator,bool> insert_unique(K&& x)
+  {
+    //to be used for finding where to put the element (a binary
+    //search, so that a run of inserts does not rebuild the model of
+    //the search policy each time)
+    iterator pos = to_iterator(binary_search_policy().lower_bound(
+      static_cast<const Key*>(start_), static_cast<const Key*>(finish_), x,
+      compare()));
+
+    //did not find element
+    if(pos == finish_ || compare()(x, *pos))
+    {
+      if(finish_ == end_)
+      {
+        size_type offset = pos - start_;
+        grow(next_capacity(size() + 1));
+        pos = start_ + offset;
+      }
+
+      if(pos == finish_)
+      {
+        construct(finish_, std::forward<K>(x));
+      }
+      else if constexpr(relocatable)
+      {
+        //copy x aside first, so that nothing has moved if it throws
+        alignas(Key) unsigned char tmp[sizeof(Key)];
+        construct(reinterpret_cast<Key*>(tmp), std::forward<K>(x));
+        detail::relocate(pos, finish_ - pos, pos + 1);
+        detail::relocate(reinterpret_cast<Key*>(tmp), 1, pos);
+      }
+      else
+      {
+        //the last element moves into raw storage, the rest shift
+        Key tmp(std::forward<K>(x));
+        construct(finish_, std::move(finish_[-1]));
+        std::move_backward(pos, finish_ - 1, finish_);
+        *pos = std::move(tmp);
+      }
+      record_moves(finish_ - pos);
+
+      ++finish_;
+      record_size();
+      if constexpr(detail::has_inserted<Search, Key>::value)
+      {
+        search().inserted(*pos);
+      }
+      else
+      {
+        search().invalidate();
+      }
+
+      return std::make_pair(pos,true);
+    }
+
+    //element found, return the end() with false
+    return std::make_pair(end(),false);
+  }
+
+  //moves the kept elements [first, last) down to out, and returns the
+  //end of the moved range; out must not be after first
+  iterator compact(iterator first, iterator last, iterator out)
+  {
+    if(out == first)
+    {
+      return last;
+    }
+    record_moves(last - first);
+    if constexpr(relocatable)
+    {
+      detail::relocate(first, last - first, out);
+      return out + (last - first);
+    }
+    else
+    {
+      return std::move(first, last, out);
+    }
+  }
+
+  //disposes of an element that erase_keys() has matched: a
+  //relocatable one is destroyed at once, since its slot will be
+  //overwritten by bytes, while any other is left to be assigned over
+  void destroy_erased(iterator pos) noexcept
+  {
+    if constexpr(relocatable)
+    {
+      destroy(pos, pos + 1);
+    }
+  }
+
+  //returns the first element not ordered before k
+  template <class K>
+  const_iterator lower_bound_of(const K& k) const
+  {
+    if constexpr(!Stats::enabled)
+    {
+      if constexpr(std::is_same_v<K, Key>)
+      {
+        return search().lower_bound(static_cast<const Key*>(start_),
+          static_cast<const Key*>(finish_), k, compare());
+      }
+      else
+      {
+        return std::lower_bound(start_, finish_, k, compare());
+      }
+    }
+    else
+    {
+      //the policy counts the probes of the search it runs, so the
+      //statistics do not change the search
+      std::size_t n = 0;
+      const_iterator pos;
+      if constexpr(std::is_same_v<K, Key>)
+      {
+        pos = detail::counted_lower_bound(search(),
+          static_cast<const Key*>(start_), static_cast<const Key*>(finish_),
+          k, compare(), n);
+      }
+      else
+      {
+        pos = std::lower_bound(start_, finish_, k,
+          detail::probe_compare<Compare>{compare(), n});
+      }
+      stats().searched(n);
+      return pos;
+    }
+  }
+
+  //returns the first element that k is ordered before
+  template <class K>
+  const_iterator upper_bound_of(const K& k) const
+  {
+    const_iterator pos = lower_bound_of(k);
+    return (pos != finish_ && !compare()(k, *pos)) ? pos + 1 : pos;
+  }
+
+  template <class K>
+  const_iterator find_impl(const K& k) const
+  {
+    if constexpr(std::is_same_v<K, Key> &&
+      detail::has_may_contain<Search, Key>::value)
+    {
+      //a filter can rule the key out without a search
+      if(!search().may_contain(static_cast<const Key*>(start_),
+        static_cast<const Key*>(finish_), k))
+      {
+        stats().searched(0);
+        return finish_;
+      }
+    }
+    const_iterator pos = lower_bound_of(k);
+    return (pos != finish_ && !compare()(k, *pos)) ? pos : finish_;
+  }
+
+  template <class K>
+  std::pair<const_iterator, const_iterator> equal_range_impl(const K& k) const
+  {
+    const_iterator pos = lower_bound_of(k);
+    if(pos != finish_ && !compare()(k, *pos))
+    {
+      return {pos, pos + 1};
+    }
+    return {pos, pos};
+  }
+
+  //calls f(key, lower bound of key) for each key in [first, last),
+  //in order; used by find_many and contains_many
+  template <class ForwardIterator, class F>
+  void for_each_lower_bound(ForwardIterator first, ForwardIterator last,
+    F f) const
+  {
+    if(std::is_sorted(first, last, compare()))
+    {
+      //gallop forward from the previous answer
+      const_iterator pos = start_;
+      for(; first != last; ++first)
+      {
+        size_type step = 1;
+        const_iterator hi = pos;
+        while(hi != finish_ && compare()(*hi, *first))
+        {
+          pos = hi + 1;
+          hi = (size_type(finish_ - hi) > step) ? hi + step : finish_;
+          step *= 2;
+        }
+        pos = std::lower_bound(pos, hi, *first, compare());
+        f(*first, pos);
+      }
+      return;
+    }
+
+    //a set this small stays in cache, so there are no misses to hide
+    if(size() * sizeof(Key) <= (size_type(1) << 16))
+    {
+      for(; first != last; ++first)
+      {
+        f(*first, lower_bound_of(*first));
+      }
+      return;
+    }
+
+    constexpr size_type group = 16;
+    ForwardIterator keys[group];
+    const_iterator base[group];
+    while(first != last)
+    {
+      size_type m = 0;
+      for(; m < group && first != last; ++m, ++first)
+      {
+        keys[m] = first;
+        base[m] = start_;
+      }
+
+      //every search in the group has the same length at each step
+      size_type len = size();
+      while(len > 1)
+      {
+        size_type half = len / 2;
+        size_type next = (len - half) / 2;
+        for(size_type i = 0; i < m; ++i)
+        {
+          base[i] = compare()(base[i][half - 1], *keys[i]) ? base[i] + half
+            : base[i];
+#if defined(__GNUC__)
+          __builtin_prefetch(base[i] + (next ? next - 1 : 0));
+#endif
+        }
+        len -= half;
+      }
+      for(size_type i = 0; i < m; ++i)
+      {
+        const_iterator pos = base[i];
+        if(len == 1 && compare()(*pos, *keys[i]))
+        {
+          ++pos;
+        }
+        f(*keys[i], pos);
+      }
     }
-    return end();
   }
 };
+
+namespace pmr {
+
+// An sv_set whose storage comes from a std::pmr::memory_resource,
+// for example a std::pmr::monotonic_buffer_resource arena.
+template <class Key , class Compare = std::less<Key>>
+using sv_set = ra::container::sv_set<Key, Compare,
+  std::pmr::polymorphic_allocator<Key>>;
+
+}
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,520 @@
+#ifndef sv_set_frozen_hpp
+#define sv_set_frozen_hpp
+
+#include <memory>
+#include <algorithm>
+#include <iterator>
+#include <new>
+#include <cstddef>
+#include "ra/sv_set.hpp"
+
+namespace ra::container {
+
+// Layout tag: keys are stored in Eytzinger (breadth-first binary
+// heap) order, so that the first levels of every search share a
+// few cache lines and the next levels can be prefetched.
+struct eytzinger_layout {};
+
+// Layout tag: keys are stored as an implicit static B-tree
+// (S-tree) whose nodes are one cache line wide, so that each
+// search step touches a single cache line.
+struct btree_layout {};
+
+// A read-only set of unique elements built from a sorted range
+// (usually an sv_set), stored in a layout chosen for fast lookups
+// rather than in sorted order.
+// Lookups are branchless and prefetch the cache lines needed by
+// later steps. Iteration visits the elements in sorted order.
+template <class Key , class Compare = std::less<Key>,
+  class Layout = eytzinger_layout>
+class sv_set_frozen {
+public:
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using layout_type = Layout ;
+  using size_type = std::size_t;
+
+  // The number of keys in each B-tree node (one cache line).
+  static constexpr size_type node_size =
+    std::max<size_type>(2, 64 / sizeof(Key));
+
+  // The non-mutable (forward) iterator type for the container.
+  // Elements are visited in sorted order.
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Key;
+    using difference_type = std::ptrdiff_t;
+    using reference = const Key&;
+    using pointer = const Key*;
+
+    const_iterator() : set_(nullptr), slot_(0) {}
+
+    reference operator*() const { return set_->data_[slot_]; }
+    pointer operator->() const { return &set_->data_[slot_]; }
+
+    const_iterator& operator++()
+    {
+      slot_ = set_->next_slot(slot_);
+      return *this;
+    }
+    const_iterator operator++(int)
+    {
+      const_iterator old(*this);
+      ++*this;
+      return old;
+    }
+
+    bool operator==(const const_iterator& other) const
+      {return slot_ == other.slot_;}
+    bool operator!=(const const_iterator& other) const
+      {return !(*this == other);}
+
+  private:
+    friend class sv_set_frozen;
+    const_iterator(const sv_set_frozen* set, size_type slot) :
+      set_(set), slot_(slot) {}
+
+    const sv_set_frozen* set_;
+    size_type slot_;
+  };
+  using iterator = const_iterator;
+
+  // Creates an empty set.
+  sv_set_frozen () noexcept : data_(nullptr), size_(0), slots_(0),
+    last_(0) {}
+
+  // Creates a set containing the elements of the sorted set s.
+  // The set s is not modified.
+  template <class Allocator , class... Policies >
+  explicit sv_set_frozen (
+  const sv_set<Key, Compare, Allocator, Policies...>& s) :
+    sv_set_frozen(s.begin(), s.size(), s.key_comp()) {}
+
+  // Creates a set containing the elements specified by the range
+  // [first, first + n), which must be both ordered and unique with
+  // respect to comp. Otherwise, the behavior is undefined.
+  template <class InputIterator >
+  sv_set_frozen (typename sv_set<Key, Compare>::ordered_and_unique_range ,
+  InputIterator first , size_type n ) :
+    sv_set_frozen(first, n, Compare()) {}
+
+  // Move construction and assignment.
+  // The source set is left empty.
+  sv_set_frozen (sv_set_frozen&& other) noexcept : sv_set_frozen()
+  {
+    swap(other);
+  }
+  sv_set_frozen& operator=(sv_set_frozen&& other) noexcept
+  {
+    if(this != &other)
+    {
+      sv_set_frozen tmp(std::move(other));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  // Copy construction and assignment.
+  sv_set_frozen (const sv_set_frozen& other) : sv_set_frozen()
+  {
+    if(other.slots_ != 0)
+    {
+      Key* data = allocate(other.slots_);
+      try
+      {
+        std::uninitialized_copy_n(other.data_, other.slots_, data);
+      } catch(...)
+      {
+        deallocate(data);
+        throw;
+      }
+      data_ = data;
+    }
+    comp_ = other.comp_;
+    size_ = other.size_;
+    slots_ = other.slots_;
+    last_ = other.last_;
+  }
+  sv_set_frozen& operator=(const sv_set_frozen& other)
+  {
+    if(this != &other)
+    {
+      sv_set_frozen tmp(other);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  ~sv_set_frozen()
+  {
+    std::destroy_n(data_, slots_);
+    deallocate(data_);
+  }
+
+  // Swaps the contents of the container with those of x.
+  void swap (sv_set_frozen& x) noexcept
+  {
+    std::swap(comp_, x.comp_);
+    std::swap(data_, x.data_);
+    std::swap(size_, x.size_);
+    std::swap(slots_, x.slots_);
+    std::swap(last_, x.last_);
+  }
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return comp_;
+  }
+
+  // Returns the number of elements in the set.
+  size_type size () const noexcept
+  {
+    return size_;
+  }
+
+  bool empty () const noexcept
+  {
+    return size_ == 0;
+  }
+
+  // Returns an iterator referring to the smallest element in the
+  // set if the set is not empty and end() otherwise.
+  const_iterator begin () const noexcept
+  {
+    if(size_ == 0)
+    {
+      return end();
+    }
+    if constexpr(std::is_same_v<Layout, btree_layout>)
+    {
+      size_type k = 0;
+      while(child(k, 0) < blocks())
+      {
+        k = child(k, 0);
+      }
+      return const_iterator(this, k * node_size);
+    }
+    else
+    {
+      size_type k = 1;
+      while(2 * k <= size_)
+      {
+        k = 2 * k;
+      }
+      return const_iterator(this, k - 1);
+    }
+  }
+
+  // Returns an iterator referring to the fictitious
+  // one-past-the-end element for the set.
+  const_iterator end () const noexcept
+  {
+    return const_iterator(this, slots_);
+  }
+
+  // Returns an iterator referring to the first element that is not
+  // ordered before k, or end() if there is no such element.
+  const_iterator lower_bound (const key_type& k) const
+  {
+    return const_iterator(this, lower_bound_slot(k));
+  }
+
+  // Searches the container for an element with the key k.
+  // If an element is found, an iterator referencing the element
+  // is returned; otherwise, end() is returned.
+  const_iterator find (const key_type& k) const
+  {
+    size_type slot = lower_bound_slot(k);
+    if(slot != slots_ && !comp_(k, data_[slot]))
+    {
+      return const_iterator(this, slot);
+    }
+    return end();
+  }
+
+  // Returns true if the set holds an element with the key k.
+  bool contains (const key_type& k) const
+  {
+    return find(k) != end();
+  }
+
+private:
+  Compare comp_;
+  //keys in layout order (Eytzinger node k lives in slot k - 1)
+  Key* data_;
+  //number of elements
+  size_type size_;
+  //number of constructed slots, including B-tree padding
+  size_type slots_;
+  //slot of the largest element
+  size_type last_;
+
+  template <class InputIterator>
+  sv_set_frozen(InputIterator first, size_type n, const Compare& comp) :
+    comp_(comp), data_(nullptr), size_(0), slots_(0), last_(0)
+  {
+    if(n == 0)
+    {
+      return;
+    }
+    size_type slots = n;
+    if constexpr(std::is_same_v<Layout, btree_layout>)
+    {
+      slots = (n + node_size - 1) / node_size * node_size;
+    }
+
+    Key* data = allocate(slots);
+    //r counts the slots constructed so far, in sorted order
+    size_type r = 0;
+    size_type last = 0;
+    try
+    {
+      for_each_slot(n, slots, [&](size_type slot) {
+        if(r < n)
+        {
+          ::new (static_cast<void*>(data + slot)) Key(*first);
+          ++first;
+          last = slot;
+        }
+        else
+        {
+          //pad unused B-tree slots with the largest key, which keeps
+          //every node sorted and can never be the first match
+          ::new (static_cast<void*>(data + slot)) Key(data[last]);
+        }
+        ++r;
+      });
+    } catch(...)
+    {
+      size_type d = 0;
+      for_each_slot(n, slots, [&](size_type slot) {
+        if(d++ < r)
+        {
+          std::destroy_at(data + slot);
+        }
+      });
+      deallocate(data);
+      throw;
+    }
+    data_ = data;
+    size_ = n;
+    slots_ = slots;
+    last_ = last;
+  }
+
+  static Key* allocate(size_type n)
+  {
+    return static_cast<Key*>(::operator new(n * sizeof(Key),
+      std::align_val_t(64)));
+  }
+
+  static void deallocate(Key* p)
+  {
+    if(p != nullptr)
+    {
+      ::operator delete(p, std::align_val_t(64));
+    }
+  }
+
+  //calls f(slot) for the slots of n elements stored in slots slots,
+  //in sorted order, so that a sorted range can be laid out in a
+  //single pass
+  template <class F>
+  static void for_each_slot(size_type n, size_type slots, F&& f)
+  {
+    if constexpr(std::is_same_v<Layout, btree_layout>)
+    {
+      (void)n;
+      for_each_btree_slot(0, slots / node_size, f);
+    }
+    else
+    {
+      (void)slots;
+      for_each_eytzinger_slot(1, n, f);
+    }
+  }
+
+  //visits the subtree rooted at node k in order
+  template <class F>
+  static void for_each_eytzinger_slot(size_type k, size_type n, F& f)
+  {
+    if(k <= n)
+    {
+      for_each_eytzinger_slot(2 * k, n, f);
+      f(k - 1);
+      for_each_eytzinger_slot(2 * k + 1, n, f);
+    }
+  }
+
+  template <class F>
+  static void for_each_btree_slot(size_type k, size_type nblocks, F& f)
+  {
+    if(k < nblocks)
+    {
+      for(size_type i = 0; i <= node_size; ++i)
+      {
+        for_each_btree_slot(child(k, i), nblocks, f);
+        if(i < node_size)
+        {
+          f(k * node_size + i);
+        }
+      }
+    }
+  }
+
+  //returns the number of trailing one bits of k
+  static unsigned trailing_ones(size_type k)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctzll(~static_cast<unsigned long long>(k));
+#else
+    unsigned n = 0;
+    for(; (k & 1) != 0; k >>= 1)
+    {
+      ++n;
+    }
+    return n;
+#endif
+  }
+
+  static constexpr size_type child(size_type k, size_type i)
+  {
+    return k * (node_size + 1) + i + 1;
+  }
+
+  size_type blocks() const
+  {
+    return slots_ / node_size;
+  }
+
+  static void prefetch(const void* p)
+  {
+#if defined(__GNUC__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+  }
+
+  //returns the slot of the first element not ordered before x,
+  //or slots_ if there is none
+  size_type lower_bound_slot(const key_type& x) const
+  {
+    if constexpr(std::is_same_v<Layout, btree_layout>)
+    {
+      size_type nblocks = blocks();
+      size_type res = slots_;
+      size_type k = 0;
+      while(k < nblocks)
+      {
+        //the children of k are contiguous, so fetch the first one
+        //while this node is being scanned
+        prefetch(reinterpret_cast<const char*>(data_) +
+          child(k, 0) * node_size * sizeof(Key));
+        const Key* node = data_ + k * node_size;
+        size_type i = 0;
+        for(size_type j = 0; j < node_size; ++j)
+        {
+          i += comp_(node[j], x);
+        }
+        if(i < node_size)
+        {
+          res = k * node_size + i;
+        }
+        k = child(k, i);
+      }
+      return res;
+    }
+    else
+    {
+      //descendants four levels down share one cache line
+      constexpr size_type ahead = sizeof(Key) <= 4 ? 16 :
+        sizeof(Key) <= 8 ? 8 : sizeof(Key) <= 16 ? 4 : 0;
+      size_type k = 1;
+      while(k <= size_)
+      {
+        if constexpr(ahead != 0)
+        {
+          prefetch(reinterpret_cast<const char*>(data_) +
+            (k * ahead - 1) * sizeof(Key));
+        }
+        k = 2 * k + comp_(data_[k - 1], x);
+      }
+      //undo the right turns made after the last left turn
+      k >>= trailing_ones(k) + 1;
+      return k == 0 ? slots_ : k - 1;
+    }
+  }
+
+  static size_type next_btree_slot(size_type slot, size_type nblocks)
+  {
+    size_type k = slot / node_size;
+    size_type i = slot % node_size;
+    size_type c = child(k, i + 1);
+    if(c < nblocks)
+    {
+      //leftmost slot of the subtree right of key i
+      while(child(c, 0) < nblocks)
+      {
+        c = child(c, 0);
+      }
+      return c * node_size;
+    }
+    if(i + 1 < node_size)
+    {
+      return slot + 1;
+    }
+    //climb until we leave a subtree that is not the last child
+    while(k != 0)
+    {
+      size_type parent = (k - 1) / (node_size + 1);
+      size_type j = (k - 1) % (node_size + 1);
+      if(j < node_size)
+      {
+        return parent * node_size + j;
+      }
+      k = parent;
+    }
+    return nblocks * node_size;
+  }
+
+  //returns the slot holding the element after the one in slot
+  size_type next_slot(size_type slot) const
+  {
+    if(slot == last_)
+    {
+      return slots_;
+    }
+    if constexpr(std::is_same_v<Layout, btree_layout>)
+    {
+      return next_btree_slot(slot, blocks());
+    }
+    else
+    {
+      size_type k = slot + 1;
+      if(2 * k + 1 <= size_)
+      {
+        //leftmost node of the right subtree
+        k = 2 * k + 1;
+        while(2 * k <= size_)
+        {
+          k = 2 * k;
+        }
+      }
+      else
+      {
+        //climb while we are a right child
+        k >>= trailing_ones(k) + 1;
+      }
+      return k - 1;
+    }
+  }
+};
+
+}
+
+#endif
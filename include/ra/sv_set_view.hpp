@@ -0,0 +1,389 @@
+#ifndef sv_set_view_hpp
+#define sv_set_view_hpp
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ra/sv_set.hpp"
+
+namespace ra::container {
+
+// The header at the start of a file written by save().
+// The keys follow at offset data_offset, as the raw bytes of a
+// sorted array of count keys of key_size bytes each.
+struct sv_set_file_header {
+  // The file format identification and version.
+  static constexpr char file_magic[8] = {'R', 'A', 'S', 'V', 'S', 'E', 'T',
+    '\0'};
+  static constexpr std::uint32_t file_version = 1;
+  // Written as is, so that a file from a machine of the other byte
+  // order is recognized.
+  static constexpr std::uint32_t native_byte_order = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint32_t key_size;
+  std::uint32_t key_align;
+  std::uint64_t count;
+  // FNV-1a hash of the key bytes.
+  std::uint64_t checksum;
+  std::uint64_t data_offset;
+  char reserved[16];
+};
+static_assert(sizeof(sv_set_file_header) == 64);
+
+// Returns the 64-bit FNV-1a hash of the n bytes at p.
+inline std::uint64_t sv_set_checksum(const void* p, std::size_t n)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(p);
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for(std::size_t i = 0; i < n; ++i)
+  {
+    hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// Writes the elements of s to the file path, in the format read by
+// sv_set_view. The file is written under a unique temporary name in
+// the same directory, flushed to disk, and then renamed, and the
+// directory is flushed too, so readers never see a partly written
+// file, even after a power loss, and concurrent saves to the same
+// path do not write to the same file.
+// Throws std::system_error if the file cannot be written.
+template <class Key , class Compare , class Allocator , class... Policies >
+void save (const sv_set<Key, Compare, Allocator, Policies...>& s ,
+const std::string& path )
+{
+  static_assert(std::is_trivially_copyable_v<Key>,
+    "only sets of trivially copyable keys can be saved");
+
+  std::size_t bytes = s.size() * sizeof(Key);
+  sv_set_file_header header{};
+  std::memcpy(header.magic, sv_set_file_header::file_magic,
+    sizeof(header.magic));
+  header.version = sv_set_file_header::file_version;
+  header.byte_order = sv_set_file_header::native_byte_order;
+  header.key_size = sizeof(Key);
+  header.key_align = alignof(Key);
+  header.count = s.size();
+  header.checksum = sv_set_checksum(s.begin(), bytes);
+  header.data_offset = sizeof(header);
+
+  std::string tmp = path + ".XXXXXX";
+  int fd = ::mkstemp(&tmp[0]);
+  if(fd < 0)
+  {
+    throw std::system_error(errno, std::generic_category(),
+      "cannot create " + tmp);
+  }
+  //errno is read right after the call that failed, before the
+  //clean-up calls can change it
+  auto fail = [&](int error, const char* what) {
+    if(fd >= 0)
+    {
+      ::close(fd);
+    }
+    ::unlink(tmp.c_str());
+    throw std::system_error(error, std::generic_category(),
+      what + (" " + tmp));
+  };
+  //mkstemp creates the file readable by its owner only
+  if(::fchmod(fd, 0644) != 0)
+  {
+    fail(errno, "cannot set the mode of");
+  }
+  auto write_all = [&](const void* p, std::size_t n) {
+    const char* bytes_left = static_cast<const char*>(p);
+    while(n != 0)
+    {
+      ssize_t written = ::write(fd, bytes_left, n);
+      if(written < 0)
+      {
+        if(errno == EINTR)
+        {
+          continue;
+        }
+        fail(errno, "cannot write");
+      }
+      bytes_left += written;
+      n -= written;
+    }
+  };
+  write_all(&header, sizeof(header));
+  write_all(s.begin(), bytes);
+  if(::fsync(fd) != 0)
+  {
+    fail(errno, "cannot flush");
+  }
+  int closed = ::close(fd);
+  fd = -1;
+  if(closed != 0)
+  {
+    fail(errno, "cannot close");
+  }
+  if(std::rename(tmp.c_str(), path.c_str()) != 0)
+  {
+    fail(errno, "cannot rename");
+  }
+  //the rename is durable only once the directory entry is on disk
+  std::string::size_type slash = path.rfind('/');
+  std::string dir = slash == std::string::npos ? std::string(".") :
+    slash == 0 ? std::string("/") : path.substr(0, slash);
+  int dir_fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+  if(dir_fd < 0)
+  {
+    throw std::system_error(errno, std::generic_category(),
+      "cannot open " + dir);
+  }
+  //EINVAL: the file system cannot flush directories
+  if(::fsync(dir_fd) != 0 && errno != EINVAL)
+  {
+    int error = errno;
+    ::close(dir_fd);
+    throw std::system_error(error, std::generic_category(),
+      "cannot flush " + dir);
+  }
+  ::close(dir_fd);
+}
+
+// A read-only set of unique elements that maps a file written by
+// save() into memory instead of loading it.
+// Nothing is copied: the elements are read straight from the page
+// cache, so opening is near-instant and every process that views
+// the same file shares its pages.
+// The Compare type must give the same order as the one the file
+// was saved with; the file records only the key size.
+template <class Key , class Compare = std::less<Key>>
+class sv_set_view {
+public:
+
+  static_assert(std::is_trivially_copyable_v<Key>,
+    "only sets of trivially copyable keys can be viewed");
+
+  using value_type = Key ;
+  using key_type = Key ;
+  using key_compare = Compare ;
+  using size_type = std::size_t;
+
+  // The (random-access) iterator type; the elements can only be
+  // read.
+  using iterator = const Key *;
+  using const_iterator = const Key *;
+
+  // Creates a view of no file, holding no elements.
+  sv_set_view () noexcept : map_(nullptr), map_size_(0), start_(nullptr),
+    finish_(nullptr) {}
+
+  // Maps the file path and checks its header.
+  // If verify is true, the checksum of the keys is also checked,
+  // which reads the whole file.
+  // Throws std::system_error if the file cannot be opened or mapped,
+  // and std::runtime_error if it is not a valid file for this key
+  // type.
+  explicit sv_set_view (const std::string& path , bool verify = false ,
+  const Compare& comp = Compare()) : sv_set_view()
+  {
+    comp_ = comp;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+      throw std::system_error(errno, std::generic_category(),
+        "cannot open " + path);
+    }
+    struct stat st;
+    if(::fstat(fd, &st) != 0)
+    {
+      int error = errno;
+      ::close(fd);
+      throw std::system_error(error, std::generic_category(),
+        "cannot stat " + path);
+    }
+    map_size_ = st.st_size;
+    if(map_size_ < sizeof(sv_set_file_header))
+    {
+      ::close(fd);
+      throw std::runtime_error(path + ": file too short");
+    }
+    void* map = ::mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if(map == MAP_FAILED)
+    {
+      throw std::system_error(error, std::generic_category(),
+        "cannot map " + path);
+    }
+    //the delegation to sv_set_view() above makes this a constructed
+    //object, so if the header is bad, the destructor unmaps the file
+    map_ = map;
+    check_header(path, verify);
+  }
+
+  // Move construction and assignment.
+  // The source view is left empty.
+  sv_set_view (sv_set_view&& other) noexcept : sv_set_view()
+  {
+    swap(other);
+  }
+  sv_set_view& operator=(sv_set_view&& other) noexcept
+  {
+    if(this != &other)
+    {
+      sv_set_view tmp(std::move(other));
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  // Do not allow the copying of views.
+  sv_set_view (const sv_set_view&) = delete;
+  sv_set_view& operator=(const sv_set_view&) = delete;
+
+  // Unmaps the file.
+  ~sv_set_view()
+  {
+    if(map_ != nullptr)
+    {
+      ::munmap(map_, map_size_);
+    }
+  }
+
+  void swap (sv_set_view& x) noexcept
+  {
+    std::swap(comp_, x.comp_);
+    std::swap(map_, x.map_);
+    std::swap(map_size_, x.map_size_);
+    std::swap(start_, x.start_);
+    std::swap(finish_, x.finish_);
+  }
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return comp_;
+  }
+
+  const_iterator begin () const noexcept { return start_; }
+  const_iterator end () const noexcept { return finish_; }
+
+  // Returns the number of elements in the set.
+  size_type size () const noexcept
+  {
+    return finish_ - start_;
+  }
+
+  bool empty () const noexcept
+  {
+    return start_ == finish_;
+  }
+
+  // Returns an iterator referring to the first element that is not
+  // ordered before k, or end() if there is no such element.
+  const_iterator lower_bound (const key_type& k ) const
+  {
+    if constexpr(ra::util::simd_searchable_v<Key, Compare>)
+    {
+      return ra::util::simd_lower_bound<Key>(start_, finish_, k);
+    }
+    else
+    {
+      return std::lower_bound(start_, finish_, k, comp_);
+    }
+  }
+
+  // Returns an iterator referring to the first element that k is
+  // ordered before, or end() if there is no such element.
+  const_iterator upper_bound (const key_type& k ) const
+  {
+    return std::upper_bound(start_, finish_, k, comp_);
+  }
+
+  // Searches the container for an element with the key k.
+  // If an element is found, an iterator referencing the element
+  // is returned; otherwise, end() is returned.
+  const_iterator find (const key_type& k ) const
+  {
+    const_iterator pos = lower_bound(k);
+    return (pos != finish_ && !comp_(k, *pos)) ? pos : finish_;
+  }
+
+  // Returns true if the set holds an element with the key k.
+  bool contains (const key_type& k ) const
+  {
+    return find(k) != finish_;
+  }
+
+  // Recomputes the checksum of the keys and compares it with the
+  // one in the file header.
+  bool verify () const
+  {
+    return map_ == nullptr || sv_set_checksum(start_, size() * sizeof(Key))
+      == header().checksum;
+  }
+
+private:
+  Compare comp_;
+  void* map_;
+  std::size_t map_size_;
+  const Key* start_;
+  const Key* finish_;
+
+  const sv_set_file_header& header() const
+  {
+    return *static_cast<const sv_set_file_header*>(map_);
+  }
+
+  void check_header(const std::string& path, bool verify_data)
+  {
+    const sv_set_file_header& h = header();
+    if(std::memcmp(h.magic, sv_set_file_header::file_magic,
+      sizeof(h.magic)) != 0)
+    {
+      throw std::runtime_error(path + ": not an sv_set file");
+    }
+    if(h.version != sv_set_file_header::file_version)
+    {
+      throw std::runtime_error(path + ": unsupported version " +
+        std::to_string(h.version));
+    }
+    if(h.byte_order != sv_set_file_header::native_byte_order)
+    {
+      throw std::runtime_error(path + ": wrong byte order");
+    }
+    if(h.key_size != sizeof(Key) || h.data_offset % alignof(Key) != 0)
+    {
+      throw std::runtime_error(path + ": key size " +
+        std::to_string(h.key_size) + " does not match " +
+        std::to_string(sizeof(Key)));
+    }
+    if(h.data_offset > map_size_ ||
+      h.count > (map_size_ - h.data_offset) / sizeof(Key))
+    {
+      throw std::runtime_error(path + ": file truncated");
+    }
+    start_ = reinterpret_cast<const Key*>(
+      static_cast<const char*>(map_) + h.data_offset);
+    finish_ = start_ + h.count;
+    if(verify_data && !verify())
+    {
+      throw std::runtime_error(path + ": checksum mismatch");
+    }
+  }
+};
+
+}
+
+#endif
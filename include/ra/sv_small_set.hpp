@@ -0,0 +1,375 @@
+#ifndef sv_small_set_hpp
+#define sv_small_set_hpp
+
+#include <memory>
+#include <algorithm>
+#include <initializer_list>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <cstddef>
+
+namespace ra::container {
+
+// A class representing a set of unique elements (which uses a
+// sorted array), where up to N elements are stored inside the set
+// object itself.
+// No memory is allocated until the set grows beyond N elements.
+// While the set is small, lookups scan the elements linearly
+// instead of using a binary search.
+// Heap storage comes from ::operator new; the set takes no
+// allocator, since an allocator that does not propagate could not
+// follow the inline elements, which are moved one by one.
+template <class Key , std::size_t N , class Compare = std::less<Key>>
+class sv_small_set {
+public:
+
+  static_assert(N > 0, "inline capacity must be positive");
+
+  // The type of the elements held by the container.
+  using value_type = Key ;
+  using key_type = Key ;
+
+  // The type of the function/functor used to compare two keys.
+  using key_compare = Compare ;
+
+  // An unsigned integral type used to represent sizes.
+  using size_type = std::size_t;
+
+  // The (random-access) iterator types for the container.
+  using iterator = Key *;
+  using const_iterator = const Key *;
+
+  // The number of elements that can be held without allocating.
+  static constexpr size_type inline_capacity = N;
+
+  // Up to this many elements, lookups use a linear scan.
+  static constexpr size_type linear_search_limit = 16;
+
+  // Creates an empty set that uses its inline storage.
+  sv_small_set () noexcept : start_(inline_data()), finish_(start_),
+    end_(start_ + N) {}
+
+  // Creates an empty set that uses its inline storage and the
+  // comparison object comp.
+  explicit sv_small_set (const Compare& comp ) : comp_(comp),
+    start_(inline_data()), finish_(start_), end_(start_ + N) {}
+
+  // Creates a set containing the elements of the initializer list,
+  // which need not be ordered or unique.
+  sv_small_set (std::initializer_list<key_type> il ) : sv_small_set()
+  {
+    for(auto&& k : il)
+    {
+      insert(k);
+    }
+  }
+
+  // Move construction.
+  // Heap storage is taken over; inline elements are moved one by
+  // one. After construction, the source set is empty.
+  sv_small_set ( sv_small_set && other ) noexcept(
+  std::is_nothrow_move_constructible_v < value_type >) : sv_small_set()
+  {
+    take(other);
+  }
+
+  // Move assignment.
+  // After the move operation, the source set is empty.
+  sv_small_set & operator=( sv_small_set && other ) noexcept(
+  std::is_nothrow_move_constructible_v < value_type >)
+  {
+    if(this != &other)
+    {
+      release();
+      take(other);
+    }
+    return *this;
+  }
+
+  // Copy construction.
+  // The constructor delegates, so that the destructor frees the
+  // heap storage if an element copy throws.
+  sv_small_set (const sv_small_set & other ) : sv_small_set(other.comp_)
+  {
+    reserve(other.size());
+    finish_ = std::uninitialized_copy(other.start_, other.finish_, start_);
+  }
+
+  // Copy assignment.
+  sv_small_set & operator=(const sv_small_set & other )
+  {
+    if(this != &other)
+    {
+      clear();
+      reserve(other.size());
+      finish_ = std::uninitialized_copy(other.start_, other.finish_, start_);
+      comp_ = other.comp_;
+    }
+    return *this;
+  }
+
+  // Erases all elements in the container and destroys the
+  // container.
+  ~sv_small_set()
+  {
+    release();
+  }
+
+  // Returns the comparison object for the container.
+  key_compare key_comp () const
+  {
+    return comp_;
+  }
+
+  const_iterator begin () const noexcept { return start_; }
+  iterator begin () noexcept { return start_; }
+  const_iterator end () const noexcept { return finish_; }
+  iterator end () noexcept { return finish_; }
+
+  // Returns the number of elements in the set.
+  size_type size () const noexcept
+  {
+    return finish_ - start_;
+  }
+
+  bool empty () const noexcept
+  {
+    return finish_ == start_;
+  }
+
+  // Returns the number of elements for which storage is
+  // available. This is never less than N.
+  size_type capacity () const noexcept
+  {
+    return end_ - start_;
+  }
+
+  // Returns true if the elements are held in the inline storage.
+  bool is_inline () const noexcept
+  {
+    return start_ == inline_data();
+  }
+
+  // Reserves storage in the container for at least n elements.
+  void reserve ( size_type n )
+  {
+    if(capacity() < n)
+    {
+      grow(n);
+    }
+  }
+
+  // Reduces the capacity of the container to the container size,
+  // moving the elements back into the inline storage if they fit.
+  void shrink_to_fit ()
+  {
+    if(capacity() > std::max(size(), N))
+    {
+      grow(size());
+    }
+  }
+
+  // Inserts the element x in the set.
+  // If the element x was inserted into the set, the pair
+  // returned has its second and first elements set to true
+  // and an iterator referring to the inserted element,
+  // respectively. Otherwise, the pair returned has its second
+  // and first elements set to false and end(), respectively.
+  std::pair<iterator,bool> insert (const key_type & x )
+  {
+    iterator pos = lower_bound_of(x);
+    if(pos != finish_ && !comp_(x, *pos))
+    {
+      return std::make_pair(end(), false);
+    }
+    if(finish_ == end_)
+    {
+      size_type offset = pos - start_;
+      grow(2 * capacity());
+      pos = start_ + offset;
+    }
+    if(pos == finish_)
+    {
+      ::new (static_cast<void*>(finish_)) Key(x);
+    }
+    else
+    {
+      //the last element moves into raw storage, the rest shift
+      Key tmp(x);
+      ::new (static_cast<void*>(finish_)) Key(std::move(finish_[-1]));
+      std::move_backward(pos, finish_ - 1, finish_);
+      *pos = std::move(tmp);
+    }
+    ++finish_;
+    return std::make_pair(pos, true);
+  }
+
+  // Erases the element referenced by pos from the container.
+  // Returns an iterator referring to the element following the
+  // erased one, or end() if there is no such element.
+  iterator erase ( const_iterator pos )
+  {
+    iterator iter = start_ + (pos - start_);
+    std::move(iter + 1, finish_, iter);
+    --finish_;
+    std::destroy_at(finish_);
+    return iter;
+  }
+
+  // Swaps the contents of the container with the contents of the
+  // container x. Heap storage is exchanged in constant time;
+  // inline elements are moved.
+  void swap ( sv_small_set& x) noexcept(
+  std::is_nothrow_move_constructible_v<value_type>)
+  {
+    if(!is_inline() && !x.is_inline())
+    {
+      std::swap(start_, x.start_);
+      std::swap(finish_, x.finish_);
+      std::swap(end_, x.end_);
+      std::swap(comp_, x.comp_);
+    }
+    else
+    {
+      //the moves carry the comparison objects along
+      sv_small_set tmp(std::move(x));
+      x = std::move(*this);
+      *this = std::move(tmp);
+    }
+  }
+
+  // Erases any elements in the container, yielding an empty
+  // container. The capacity is unchanged.
+  void clear () noexcept
+  {
+    std::destroy(start_, finish_);
+    finish_ = start_;
+  }
+
+  // Searches the container for an element with the key k.
+  // If an element is found, an iterator referencing the element
+  // is returned; otherwise, end() is returned.
+  iterator find (const key_type & k )
+  {
+    return const_cast<iterator>(std::as_const(*this).find(k));
+  }
+
+  const_iterator find (const key_type & k ) const
+  {
+    const_iterator pos = lower_bound_of(k);
+    if(pos != finish_ && !comp_(k, *pos))
+    {
+      return pos;
+    }
+    return end();
+  }
+
+  // Returns true if the set holds an element with the key k.
+  bool contains (const key_type & k ) const
+  {
+    return find(k) != end();
+  }
+
+private:
+  Compare comp_;
+  Key* start_;
+  Key* finish_;
+  Key* end_;
+  alignas(Key) unsigned char buffer_[N * sizeof(Key)];
+
+  Key* inline_data() noexcept
+  {
+    return reinterpret_cast<Key*>(buffer_);
+  }
+
+  const Key* inline_data() const noexcept
+  {
+    return reinterpret_cast<const Key*>(buffer_);
+  }
+
+  //destroys the elements and frees any heap storage
+  void release() noexcept
+  {
+    clear();
+    if(!is_inline())
+    {
+      ::operator delete(start_);
+    }
+    start_ = finish_ = inline_data();
+    end_ = start_ + N;
+  }
+
+  //moves the contents of other into *this, which must be empty
+  //and inline
+  void take(sv_small_set& other)
+  {
+    comp_ = other.comp_;
+    if(!other.is_inline())
+    {
+      start_ = other.start_;
+      finish_ = other.finish_;
+      end_ = other.end_;
+      other.start_ = other.finish_ = other.inline_data();
+      other.end_ = other.start_ + N;
+      return;
+    }
+    finish_ = std::uninitialized_move(other.start_, other.finish_, start_);
+    other.clear();
+  }
+
+  //moves the elements to storage for n elements, which is the
+  //inline buffer if n is at most N
+  void grow(size_type n)
+  {
+    Key* new_start = n <= N ? inline_data() :
+      static_cast<Key*>(::operator new(n * sizeof(Key)));
+    if(new_start == start_)
+    {
+      return;
+    }
+    size_type old_size = size();
+    try
+    {
+      std::uninitialized_move(start_, finish_, new_start);
+    } catch(...)
+    {
+      if(new_start != inline_data())
+      {
+        ::operator delete(new_start);
+      }
+      throw;
+    }
+    clear();
+    if(!is_inline())
+    {
+      ::operator delete(start_);
+    }
+    start_ = new_start;
+    finish_ = start_ + old_size;
+    end_ = start_ + std::max(n, N);
+  }
+
+  const_iterator lower_bound_of(const key_type& k) const
+  {
+    if(size() <= linear_search_limit)
+    {
+      const_iterator pos = start_;
+      while(pos != finish_ && comp_(*pos, k))
+      {
+        ++pos;
+      }
+      return pos;
+    }
+    return std::lower_bound(start_, finish_, k, comp_);
+  }
+
+  iterator lower_bound_of(const key_type& k)
+  {
+    return const_cast<iterator>(std::as_const(*this).lower_bound_of(k));
+  }
+};
+
+}
+
+#endif
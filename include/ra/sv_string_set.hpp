@@ -0,0 +1,470 @@
+#ifndef sv_string_set_hpp
+#define sv_string_set_hpp
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ra::container {
+
+// A set of unique strings in lexicographic order (as for
+// std::less<std::string>), which packs the bytes of all the strings
+// into one arena.
+// The set is a sorted array of 16-byte entries. Each entry holds the
+// first 8 bytes of its string (the prefix, as a big-endian integer)
+// and the offset and length of the string in the arena. Most
+// comparisons of a search are decided by the prefixes alone, so a
+// probe reads only the array of entries; the arena is read when two
+// prefixes are equal.
+// Compared with an sv_set<std::string>, a string takes 16 bytes plus
+// its length instead of 32 bytes (plus a separate heap block once it
+// is longer than 15 bytes).
+// Inserting a string appends its bytes to the arena. Erasing leaves
+// its bytes in place; once half the arena is unused, it is
+// compacted (which also lays the strings out in sorted order).
+// A string may be up to 16 MiB long, and the arena up to 1 TiB.
+// Lookups take a std::string_view, so std::string and C strings
+// can be looked up without a copy.
+class sv_string_set {
+  struct entry;
+
+public:
+
+  using value_type = std::string_view;
+  using key_type = std::string_view;
+  using size_type = std::size_t;
+
+  // The longest string the set can hold.
+  static constexpr size_type max_length = (size_type(1) << 24) - 1;
+
+  // A random-access iterator over the strings of the set in order;
+  // *it is a std::string_view of the string, valid until the set is
+  // next modified.
+  class const_iterator {
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using reference = std::string_view;
+
+    // The result of operator->, which holds the string_view.
+    struct pointer {
+      std::string_view view;
+      const std::string_view* operator->() const noexcept { return &view; }
+    };
+
+    const_iterator () noexcept : arena_(nullptr), entry_(nullptr) {}
+
+    reference operator*() const noexcept { return entry_->view(arena_); }
+    pointer operator->() const noexcept { return pointer{**this}; }
+    reference operator[](difference_type n) const noexcept
+    {
+      return entry_[n].view(arena_);
+    }
+
+    const_iterator& operator++() noexcept { ++entry_; return *this; }
+    const_iterator& operator--() noexcept { --entry_; return *this; }
+    const_iterator operator++(int) noexcept
+    {
+      const_iterator tmp(*this);
+      ++entry_;
+      return tmp;
+    }
+    const_iterator operator--(int) noexcept
+    {
+      const_iterator tmp(*this);
+      --entry_;
+      return tmp;
+    }
+    const_iterator& operator+=(difference_type n) noexcept
+    {
+      entry_ += n;
+      return *this;
+    }
+    const_iterator& operator-=(difference_type n) noexcept
+    {
+      entry_ -= n;
+      return *this;
+    }
+    friend const_iterator operator+(const_iterator it, difference_type n)
+      noexcept
+    {
+      return it += n;
+    }
+    friend const_iterator operator+(difference_type n, const_iterator it)
+      noexcept
+    {
+      return it += n;
+    }
+    friend const_iterator operator-(const_iterator it, difference_type n)
+      noexcept
+    {
+      return it -= n;
+    }
+    friend difference_type operator-(const const_iterator& a,
+      const const_iterator& b) noexcept
+    {
+      return a.entry_ - b.entry_;
+    }
+
+    friend bool operator==(const const_iterator& a, const const_iterator& b)
+      noexcept { return a.entry_ == b.entry_; }
+    friend bool operator!=(const const_iterator& a, const const_iterator& b)
+      noexcept { return a.entry_ != b.entry_; }
+    friend bool operator<(const const_iterator& a, const const_iterator& b)
+      noexcept { return a.entry_ < b.entry_; }
+    friend bool operator>(const const_iterator& a, const const_iterator& b)
+      noexcept { return a.entry_ > b.entry_; }
+    friend bool operator<=(const const_iterator& a, const const_iterator& b)
+      noexcept { return a.entry_ <= b.entry_; }
+    friend bool operator>=(const const_iterator& a, const const_iterator& b)
+      noexcept { return a.entry_ >= b.entry_; }
+
+  private:
+    friend class sv_string_set;
+
+    const_iterator (const char* arena , const entry* e ) noexcept :
+      arena_(arena), entry_(e) {}
+
+    const char* arena_;
+    const entry* entry_;
+  };
+
+  using iterator = const_iterator;
+
+  // Creates an empty set.
+  sv_string_set () noexcept : unused_(0) {}
+
+  // Creates a set holding the strings in the range [first, last),
+  // which need not be ordered or unique. The value type of the
+  // iterators must convert to std::string_view.
+  // Throws std::length_error if a string is longer than max_length.
+  // The strings are copied into the arena in one pass, then their
+  // entries are sorted and deduplicated, and the arena is laid out
+  // again in sorted order.
+  template <class InputIterator >
+  sv_string_set ( InputIterator first , InputIterator last ) :
+    unused_(0)
+  {
+    for(; first != last; ++first)
+    {
+      //*first may be a std::string returned by value, so it is bound
+      //to a reference that lives until append has copied it
+      auto&& v = *first;
+      entries_.push_back(append(std::string_view(v)));
+    }
+    const char* arena = arena_.data();
+    std::sort(entries_.begin(), entries_.end(),
+      [arena](const entry& a, const entry& b) {
+        return a.less(arena, b.prefix, b.view(arena));
+      });
+    auto last_unique = std::unique(entries_.begin(), entries_.end(),
+      [arena](const entry& a, const entry& b) {
+        return a.prefix == b.prefix && a.view(arena) == b.view(arena);
+      });
+    for(auto it = last_unique; it != entries_.end(); ++it)
+    {
+      unused_ += it->length();
+    }
+    entries_.erase(last_unique, entries_.end());
+    entries_.shrink_to_fit();
+    compact();
+  }
+
+  // Creates a set holding the strings of il (see above).
+  sv_string_set ( std::initializer_list<std::string_view> il ) :
+    sv_string_set(il.begin(), il.end()) {}
+
+  const_iterator begin () const noexcept
+  {
+    return const_iterator(arena_.data(), entries_.data());
+  }
+  const_iterator end () const noexcept
+  {
+    return const_iterator(arena_.data(), entries_.data() + entries_.size());
+  }
+
+  // Returns the number of strings in the set.
+  size_type size () const noexcept
+  {
+    return entries_.size();
+  }
+
+  bool empty () const noexcept
+  {
+    return entries_.empty();
+  }
+
+  // Returns the number of bytes of strings held in the arena,
+  // including those of erased strings not yet compacted away.
+  size_type arena_size () const noexcept
+  {
+    return arena_.size();
+  }
+
+  // Returns the number of bytes of heap memory used by the set.
+  size_type memory_bytes () const noexcept
+  {
+    return entries_.capacity() * sizeof(entry) + arena_.capacity();
+  }
+
+  // Reserves storage for n strings of total length bytes.
+  void reserve ( size_type n , size_type bytes )
+  {
+    entries_.reserve(n);
+    arena_.reserve(bytes);
+  }
+
+  // Erases all strings in the set.
+  void clear () noexcept
+  {
+    entries_.clear();
+    arena_.clear();
+    unused_ = 0;
+  }
+
+  // Inserts a copy of the string s in the set, unless it is already
+  // there.
+  // Returns an iterator referring to the string in the set, and true
+  // if it was inserted.
+  // Throws std::length_error if s is longer than max_length.
+  std::pair<const_iterator, bool> insert ( std::string_view s )
+  {
+    std::uint64_t p = prefix_of(s);
+    size_type i = lower_bound_index(p, s);
+    if(i != entries_.size() && entries_[i].equals(arena_.data(), p, s))
+    {
+      return std::make_pair(begin() + i, false);
+    }
+    size_type old_size = arena_.size();
+    entry e = append(s);
+    try
+    {
+      entries_.insert(entries_.begin() + i, e);
+    } catch(...)
+    {
+      arena_.resize(old_size);
+      throw;
+    }
+    return std::make_pair(begin() + i, true);
+  }
+
+  // Erases the string referenced by pos.
+  // Returns an iterator referring to the string that followed it.
+  const_iterator erase ( const_iterator pos )
+  {
+    size_type i = pos - begin();
+    unused_ += entries_[i].length();
+    entries_.erase(entries_.begin() + i);
+    if(unused_ > arena_.size() / 2)
+    {
+      try
+      {
+        compact();
+      } catch(const std::bad_alloc&)
+      {
+        //the arena is still valid; try again at the next erasure
+      }
+    }
+    return begin() + i;
+  }
+
+  // Erases the string s, if it is in the set.
+  // Returns the number of strings erased (zero or one).
+  size_type erase ( std::string_view s )
+  {
+    const_iterator pos = find(s);
+    if(pos == end())
+    {
+      return 0;
+    }
+    erase(pos);
+    return 1;
+  }
+
+  // Returns an iterator referring to the first string that is not
+  // ordered before s, or end() if there is no such string.
+  const_iterator lower_bound ( std::string_view s ) const
+  {
+    return begin() + lower_bound_index(prefix_of(s), s);
+  }
+
+  // Returns an iterator referring to the first string that s is
+  // ordered before, or end() if there is no such string.
+  const_iterator upper_bound ( std::string_view s ) const
+  {
+    std::uint64_t p = prefix_of(s);
+    size_type i = lower_bound_index(p, s);
+    if(i != entries_.size() && entries_[i].equals(arena_.data(), p, s))
+    {
+      ++i;
+    }
+    return begin() + i;
+  }
+
+  // Searches the set for the string s.
+  // If it is found, an iterator referring to it is returned;
+  // otherwise, end() is returned.
+  const_iterator find ( std::string_view s ) const
+  {
+    std::uint64_t p = prefix_of(s);
+    size_type i = lower_bound_index(p, s);
+    if(i != entries_.size() && entries_[i].equals(arena_.data(), p, s))
+    {
+      return begin() + i;
+    }
+    return end();
+  }
+
+  // Returns true if the set holds the string s.
+  bool contains ( std::string_view s ) const
+  {
+    return find(s) != end();
+  }
+
+  // Returns the number of strings equal to s (zero or one).
+  size_type count ( std::string_view s ) const
+  {
+    return contains(s) ? 1 : 0;
+  }
+
+  // Drops the bytes of erased strings from the arena, lays out the
+  // strings in sorted order, and frees any unused capacity.
+  void shrink_to_fit ()
+  {
+    compact();
+    entries_.shrink_to_fit();
+  }
+
+  void swap ( sv_string_set & x ) noexcept
+  {
+    entries_.swap(x.entries_);
+    arena_.swap(x.arena_);
+    std::swap(unused_, x.unused_);
+  }
+
+private:
+  struct entry {
+    //the first 8 bytes, big-endian and padded with zeros, so that
+    //comparing prefixes as integers compares the strings' starts
+    std::uint64_t prefix;
+    //the offset of the string in the arena (low 40 bits) and its
+    //length (high 24 bits)
+    std::uint64_t location;
+
+    size_type offset() const noexcept
+    {
+      return location & ((std::uint64_t(1) << 40) - 1);
+    }
+    size_type length() const noexcept
+    {
+      return location >> 40;
+    }
+    std::string_view view(const char* arena) const noexcept
+    {
+      return std::string_view(arena + offset(), length());
+    }
+
+    //true if this string is ordered before s, whose prefix is p
+    bool less(const char* arena, std::uint64_t p, std::string_view s) const
+      noexcept
+    {
+      if(prefix != p)
+      {
+        return prefix < p;
+      }
+      return view(arena) < s;
+    }
+
+    bool equals(const char* arena, std::uint64_t p, std::string_view s) const
+      noexcept
+    {
+      return prefix == p && length() == s.size() &&
+        (s.size() <= 8 || std::memcmp(arena + offset() + 8, s.data() + 8,
+          s.size() - 8) == 0);
+    }
+  };
+  static_assert(sizeof(entry) == 16);
+
+  std::vector<entry> entries_;
+  std::vector<char> arena_;
+  //bytes of the arena no longer referred to by any entry
+  size_type unused_;
+
+  static std::uint64_t prefix_of(std::string_view s) noexcept
+  {
+    std::uint64_t p = 0;
+    size_type n = std::min<size_type>(s.size(), 8);
+    for(size_type i = 0; i < n; ++i)
+    {
+      p |= std::uint64_t(static_cast<unsigned char>(s[i])) << (56 - 8 * i);
+    }
+    return p;
+  }
+
+  //copies s to the end of the arena, and returns its entry; s may
+  //view the arena itself (a substring of an element), in which case
+  //it is found again by its offset once the arena has grown
+  entry append(std::string_view s)
+  {
+    if(s.size() > max_length)
+    {
+      throw std::length_error("sv_string_set: string too long");
+    }
+    if(arena_.size() + s.size() >= (std::uint64_t(1) << 40))
+    {
+      throw std::length_error("sv_string_set: arena full");
+    }
+    entry e;
+    e.prefix = prefix_of(s);
+    size_type old_size = arena_.size();
+    e.location = std::uint64_t(old_size) | std::uint64_t(s.size()) << 40;
+    const char* data = arena_.data();
+    std::less<const char*> before;
+    bool aliased = !s.empty() && !before(s.data(), data) &&
+      before(s.data(), data + old_size);
+    size_type offset = aliased ? size_type(s.data() - data) : 0;
+    arena_.resize(old_size + s.size());
+    const char* from = aliased ? arena_.data() + offset : s.data();
+    std::copy(from, from + s.size(), arena_.data() + old_size);
+    return e;
+  }
+
+  size_type lower_bound_index(std::uint64_t p, std::string_view s) const
+  {
+    const char* arena = arena_.data();
+    return std::lower_bound(entries_.begin(), entries_.end(), s,
+      [arena, p](const entry& e, std::string_view k) {
+        return e.less(arena, p, k);
+      }) - entries_.begin();
+  }
+
+  //rebuilds the arena with only the strings of the set, in order
+  void compact()
+  {
+    size_type bytes = arena_.size() - unused_;
+    std::vector<char> arena;
+    arena.reserve(bytes);
+    for(entry& e : entries_)
+    {
+      std::string_view s = e.view(arena_.data());
+      e.location = std::uint64_t(arena.size()) | std::uint64_t(s.size()) << 40;
+      arena.insert(arena.end(), s.begin(), s.end());
+    }
+    arena_.swap(arena);
+    unused_ = 0;
+  }
+};
+
+}
+
+#endif